@@ -92,8 +92,9 @@ void decel_vel(Vec2& vel, int cur_vel_level)
         decel_vel(vel);
     else
     {
-        static const float coef[] = {0,0.000000,0.500000,0.666667,0.750000,0.800000,0.833333,0.857143,0.875000,0.888889,0.900000,0.909091,0.916667,0.923077,0.928571};
-        vel *= coef[cur_vel_level];;
+        // vel_level は速さを CharaDecelSpeed 単位で表したもの
+        const float speed = cur_vel_level * Parameter::CharaDecelSpeed();
+        vel *= (speed - Parameter::CharaDecelSpeed()) / speed;
     }
 }
 
@@ -106,6 +107,55 @@ bool is_equal(const Vec2& a, const Vec2& b)
     return abs(dx) + abs(dy) < 1e-4;
 }
 
+// Collision::IsHit(lotus.region(), prevRegion, pos) と同じ判定を平方根を使わずに行う
+// 中心 center、半径の二乗 sq_r の円と、from から to への線分が交差するか (接する場合も含む)
+bool swept_hit(const Vec2& center, float sq_r, const Vec2& from, const Vec2& to)
+{
+    const Vec2 from_to_center = center - from;
+    const Vec2 to_to_center = center - to;
+    if (to_to_center.squareLength() <= sq_r || from_to_center.squareLength() <= sq_r)
+        return true;
+
+    // 動いていなければ両端の判定だけ
+    const Vec2 seg = to - from;
+    if (seg.isZero())
+        return false;
+
+    // 線分を含む直線との距離 |cross| / |seg| が半径以下で、両端が円の反対側にある
+    const float cross = seg.cross(from_to_center);
+    if (cross * cross > sq_r * seg.squareLength())
+        return false;
+    return from_to_center.dot(seg) * to_to_center.dot(seg) <= 0;
+}
+
+// Chara::correctInside と同じ補正を行い、補正したら true を返す (その場合、速度は 0 になる)
+bool correct_inside(Vec2& pos, const Rectangle& rect)
+{
+    const float radius = Parameter::CharaRadius();
+    bool corrected = false;
+    if (pos.x - radius < rect.left)
+    {
+        pos.x = rect.left + radius;
+        corrected = true;
+    }
+    else if (rect.right < pos.x + radius)
+    {
+        pos.x = rect.right - radius;
+        corrected = true;
+    }
+    if (pos.y - radius < rect.bottom)
+    {
+        pos.y = rect.bottom + radius;
+        corrected = true;
+    }
+    else if (rect.top < pos.y + radius)
+    {
+        pos.y = rect.top - radius;
+        corrected = true;
+    }
+    return corrected;
+}
+
 void search_path(const StageAccessor& stage_accessor, Vec2* target_pos)
 {
     const LotusCollection& lotuses = stage_accessor.lotuses();
@@ -120,27 +170,109 @@ void search_path(const StageAccessor& stage_accessor, Vec2* target_pos)
         for (int i = 1; i < 3; ++i)
             target_pos[target_lotus + i * lotuses.count()] = target_pos[target_lotus];
     }
+    // ゴール後の番兵
+    target_pos[lotuses.count() * Parameter::StageRoundCount] = target_pos[lotuses.count() - 1];
 }
 
 
 const int MAX_SEARCH_TURN = 405;
+const int MIN_SEARCH_TURN = 20;
+const int MAX_VEL_LEVEL = 14; // Parameter::CharaAccelSpeed / Parameter::CharaDecelSpeed
+
+// DP の状態 (加速回数, 速度レベル) を 1 バイトに詰める
+uchar pack_cell(int accel_count, int vel_level) { return accel_count * MAX_VEL_LEVEL + vel_level; }
+int cell_accel_count(uchar cell) { return cell / MAX_VEL_LEVEL; }
+int cell_vel_level(uchar cell) { return cell % MAX_VEL_LEVEL; }
+
+// 探索で展開した状態数
+// ステージごとに数え、1 回の探索の差分を SolverStats に渡す (1 ステージで 2^31 には届かない)
+struct SearchStats
+{
+    int searches;
+    int expanded_cells;
+
+    SearchStats() { reset(); }
+    void reset()
+    {
+        searches = expanded_cells = 0;
+    }
+};
+
+// 1 ターンに掛かる時間をゲーム全体の平均で見積もり、ターンに割り当てられた時間を超えていれば探索を浅くする
+// 探索の時間はおおむね深さに比例するので、超えた割合だけ深さを減らす
+const int PACE_MIN_TURN = 1000; // 平均を使い始めるまでのターン数 (最初の数ステージは短く、平均がぶれる)
+struct SearchPace
+{
+    int turns;
+
+    SearchPace() : turns(0) {}
+
+    int depth(const TimeBudget& budget, int passed_turn) const
+    {
+        // 平均が定まるまでと、ゲームの外 (割り当てがない) では最大まで探索する
+        if (!budget.isStarted() || turns < PACE_MIN_TURN)
+            return MAX_SEARCH_TURN - 1;
+        const double sec_per_turn = budget.answerSec() / turns;
+        const double turn_budget_sec = budget.turnBudgetSec(passed_turn);
+        if (sec_per_turn <= turn_budget_sec)
+            return MAX_SEARCH_TURN - 1;
+        return solver::max(MIN_SEARCH_TURN, (int)((MAX_SEARCH_TURN - 1) * turn_budget_sec / sec_per_turn));
+    }
+};
+
+// 探索を始める状態
+struct PlanState
+{
+    Vec2 pos;
+    Vec2 vel;
+    int accel_count;
+    int accel_wait_turn;
+    int passed_lotus;
+
+    explicit PlanState(const Chara& chara)
+        : pos(chara.pos()), vel(chara.vel()), accel_count(chara.accelCount()),
+        accel_wait_turn(chara.accelWaitTurn()), passed_lotus(chara.passedLotusCount())
+    {
+    }
+};
+
 class ActionStrategy
 {
 public:
     ActionStrategy()
-        : cache_i(0), cache_size(0)
+        : cache_i(0), cache_size(0), from_segment(false)
     {
     }
 
     void reset()
     {
         cache_i = cache_size = 0;
+        from_segment = false;
+        search_stats.reset();
     }
 
+    const SearchStats& stats() const { return search_stats; }
+
     int size() const { return cache_size; }
     int index() const { return cache_i; }
     bool cached_strategy() const { return cache_i < cache_size; }
 
+    // 探索し直すまでに使う行動の数
+    // 探索結果は先の方ほど不確かなので途中で探索し直すが、再利用した行動列は検証済みなので最後まで使う
+    int replan_size() const { return from_segment ? cache_size : cache_size * 6 / 10; }
+    bool segment_plan() const { return from_segment; }
+
+    // PlanSegmentCache から取り出した行動列を計画として使う
+    void load_segment(const Action* actions, int size)
+    {
+        assert(0 < size && size <= MAX_SEARCH_TURN);
+        rep(i, size)
+            cache_action[i] = actions[i];
+        cache_i = 0;
+        cache_size = size;
+        from_segment = true;
+    }
+
     void next_turn()
     {
         ++cache_i;
@@ -155,59 +287,78 @@ public:
 private:
     int cache_i;
     int cache_size;
+    bool from_segment;
     Action cache_action[MAX_SEARCH_TURN];
 
+    SearchStats search_stats;
+
 public:
     void search(const StageAccessor& stage_accessor, const Vec2* target_pos, const int search_turns, const int rem_accel_count)
     {
+        PerfScope perf_scope(PerfRegion_Search);
+        TraceScope trace_scope("ActionStrategy::search");
         assert(0 <= search_turns && search_turns < MAX_SEARCH_TURN);
 
-        const Chara& player = stage_accessor.player();
+        const PlanState start(stage_accessor.player());
+
         const LotusCollection& lotuses = stage_accessor.lotuses();
         const Field& field = stage_accessor.field();
 
         const float flow_vel_y = field.flowVel().y;
         const bool flow = flow_vel_y > 0;
 
+        const Rectangle& field_rect = field.rect();
+        const int goal_lotus = lotuses.count() * Parameter::StageRoundCount;
+
+        Vec2 lotus_pos[Parameter::LotusCountMax];
         float collision_squared_dist[Parameter::LotusCountMax];
         rep(target_lotus, lotuses.count())
         {
             const Lotus& lotus = lotuses[target_lotus];
-            const float collision_dist = lotus.radius() + Parameter::CharaRadius();
-            collision_squared_dist[target_lotus] = collision_dist * collision_dist - 1e-7;
+            const float hit_dist = lotus.radius() + Parameter::CharaRadius();
+            lotus_pos[target_lotus] = lotus.pos();
+            collision_squared_dist[target_lotus] = hit_dist * hit_dist - 1e-7;
         }
 
-        const int MAX_VEL_LEVEL = 14; // Parameter::CharaAccelSpeed / Parameter::CharaDecelSpeed
-        static Vec2 dp_pos[MAX_SEARCH_TURN][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
-        static Vec2 dp_vel[MAX_SEARCH_TURN][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
+        // 位置と速度は展開中の 2 層分だけ持つ
+        // 全ターン分持つのは通過した蓮の数と 1 バイトに詰めた遷移元だけで、
+        // 行動は遷移先の vel_level (加速直後だけ MAX_VEL_LEVEL - 1)、加速の目標は遷移元の蓮の数から復元する
+        static Vec2 layer_pos[2][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
+        static Vec2 layer_vel[2][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
         static char dp_passed_lotus[MAX_SEARCH_TURN][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
-        static ushort dp_prev[MAX_SEARCH_TURN][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
-        static Action dp_action[MAX_SEARCH_TURN][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
-        const Action WAIT_ACTION = Action::Wait();
+        static uchar dp_prev[MAX_SEARCH_TURN][CharaAccelCountMax + 1][MAX_VEL_LEVEL];
 
-        const int upper_accel_count = min(CharaAccelCountMax, player.accelCount() + (flow ? 3 : 2));
+        const int upper_accel_count = min(CharaAccelCountMax, start.accel_count + (flow ? 3 : 2));
 //         const int upper_accel_count = CharaAccelCountMax;
 
         erep(dp_i, search_turns) erep(accel_count, upper_accel_count) rep(vel_level, MAX_VEL_LEVEL)
             dp_passed_lotus[dp_i][accel_count][vel_level] = -5;
-        dp_pos[0][player.accelCount()][0] = player.pos();
-        dp_vel[0][player.accelCount()][0] = player.vel();
-        dp_passed_lotus[0][player.accelCount()][0] = player.passedLotusCount();
-        dp_prev[0][player.accelCount()][0] = 0;
+        layer_pos[0][start.accel_count][0] = start.pos;
+        layer_vel[0][start.accel_count][0] = start.vel;
+        dp_passed_lotus[0][start.accel_count][0] = start.passed_lotus;
+        dp_prev[0][start.accel_count][0] = 0;
 
 
         int target_lotus_table[Parameter::LotusCountMax * Parameter::StageRoundCount + 1];
         rep(passed_lotus, lotuses.count() * Parameter::StageRoundCount + 1)
             target_lotus_table[passed_lotus] = passed_lotus % lotuses.count();
 
+        ++search_stats.searches;
+
         int searching_turn = 0;
-        int accel_wait_turn = player.accelWaitTurn();
+        int accel_wait_turn = start.accel_wait_turn;
         rep(dp_i, search_turns)
         {
             const int add_accel_count = --accel_wait_turn == 0;
             if (accel_wait_turn == 0)
                 accel_wait_turn = CharaAccelCountMax + 1;
 
+            const int cur_layer = dp_i & 1;
+            const int next_layer = cur_layer ^ 1;
+            Vec2 (&cur_layer_pos)[CharaAccelCountMax + 1][MAX_VEL_LEVEL] = layer_pos[cur_layer];
+            Vec2 (&next_layer_pos)[CharaAccelCountMax + 1][MAX_VEL_LEVEL] = layer_pos[next_layer];
+            Vec2 (&next_layer_vel)[CharaAccelCountMax + 1][MAX_VEL_LEVEL] = layer_vel[next_layer];
+
             bool found_goal = false;
 //             for (int accel_count = upper_accel_count; accel_count >= 0; --accel_count)
             for (int accel_count = 0; accel_count <= upper_accel_count; ++accel_count)
@@ -218,12 +369,13 @@ public:
                     if (dp_passed_lotus[dp_i][accel_count][vel_level] < 0)
                         continue;
 
+                    ++search_stats.expanded_cells;
+
                     const int passed_lotus = dp_passed_lotus[dp_i][accel_count][vel_level];
-                    const int target_lotus = target_lotus_table[passed_lotus];
                     const Vec2& cur_target_pos = target_pos[passed_lotus];
 
-                    const Vec2& cur_pos = dp_pos[dp_i][accel_count][vel_level];
-                    const Vec2& cur_vel = dp_vel[dp_i][accel_count][vel_level];
+                    const Vec2& cur_pos = cur_layer_pos[accel_count][vel_level];
+                    const Vec2& cur_vel = layer_vel[cur_layer][accel_count][vel_level];
 
                     // wait
                     {
@@ -233,20 +385,22 @@ public:
                         Vec2 next_pos = cur_vel;
                         next_pos.y += field.flowVel().y;
                         next_pos += cur_pos;
+                        const bool corrected = correct_inside(next_pos, field_rect);
 
-                        const int next_passed_lotus = passed_lotus + (next_pos.squareDist(lotuses[target_lotus].pos()) < collision_squared_dist[target_lotus]);
+                        const int target_lotus = target_lotus_table[passed_lotus];
+                        const int next_passed_lotus = passed_lotus + (next_pos.squareDist(lotus_pos[target_lotus]) < collision_squared_dist[target_lotus]);
 
                         Vec2 next_target_pos = target_pos[next_passed_lotus];
                         if (flow)
                             next_target_pos.y -= cur_pos.dist(target_pos[next_passed_lotus]) * flow_vel_y;
 
                         if (
-                                vel_level > 1 ||
+                                (vel_level > 1 && !corrected) ||
                                 (
                                  next_passed_lotus > dp_passed_lotus[dp_i + 1][naccel_count][nvel_level] ||
                                  (
                                   next_passed_lotus == dp_passed_lotus[dp_i + 1][naccel_count][nvel_level] &&
-                                  next_pos.squareDist(next_target_pos) < dp_pos[dp_i + 1][naccel_count][nvel_level].squareDist(next_target_pos)
+                                  next_pos.squareDist(next_target_pos) < next_layer_pos[naccel_count][nvel_level].squareDist(next_target_pos)
                                  )
                                 )
                            )
@@ -254,17 +408,19 @@ public:
                             assert(0 <= naccel_count && naccel_count <= CharaAccelCountMax);
                             assert(0 <= nvel_level && nvel_level <= MAX_VEL_LEVEL);
 
-                            dp_pos[dp_i + 1][naccel_count][nvel_level] = next_pos;
+                            next_layer_pos[naccel_count][nvel_level] = next_pos;
 
                             Vec2 next_vel = cur_vel;
-                            decel_vel(next_vel, vel_level);
-                            dp_vel[dp_i + 1][naccel_count][nvel_level] = next_vel;
+                            if (corrected)
+                                next_vel.reset();
+                            else
+                                decel_vel(next_vel, vel_level);
+                            next_layer_vel[naccel_count][nvel_level] = next_vel;
 
                             dp_passed_lotus[dp_i + 1][naccel_count][nvel_level] = next_passed_lotus;
-                            dp_prev[dp_i + 1][naccel_count][nvel_level] = pcc(accel_count, vel_level);
-                            dp_action[dp_i + 1][naccel_count][nvel_level] = WAIT_ACTION;
+                            dp_prev[dp_i + 1][naccel_count][nvel_level] = pack_cell(accel_count, vel_level);
 
-                            if (next_passed_lotus == lotuses.count() * Parameter::StageRoundCount)
+                            if (next_passed_lotus == goal_lotus)
                                 found_goal = true;
                         }
                     }
@@ -282,8 +438,12 @@ public:
                         Vec2 next_pos = acceled_vel;
                         next_pos.y += flow_vel_y;
                         next_pos += cur_pos;
+                        // 壁で止まっても遷移先は加速直後の vel_level のままにする (行動の復元に使うため)
+                        // 速度は 0 になり、以降の減速でも 0 のまま
+                        const bool corrected = correct_inside(next_pos, field_rect);
 
-                        const int next_passed_lotus = passed_lotus + (next_pos.squareDist(lotuses[target_lotus].pos()) < collision_squared_dist[target_lotus]);
+                        const int target_lotus = target_lotus_table[passed_lotus];
+                        const int next_passed_lotus = passed_lotus + (next_pos.squareDist(lotus_pos[target_lotus]) < collision_squared_dist[target_lotus]);
 
                         Vec2 next_target_pos = target_pos[next_passed_lotus];
                         if (flow)
@@ -297,21 +457,23 @@ public:
                                  next_passed_lotus > dp_passed_lotus[dp_i + 1][naccel_count][nvel_level] ||
                                  (
                                   next_passed_lotus == dp_passed_lotus[dp_i + 1][naccel_count][nvel_level] &&
-                                  next_pos.squareDist(next_target_pos) < dp_pos[dp_i + 1][naccel_count][nvel_level].squareDist(next_target_pos)
+                                  next_pos.squareDist(next_target_pos) < next_layer_pos[naccel_count][nvel_level].squareDist(next_target_pos)
                                  )
                                 )
                            )
                         {
-                            dp_pos[dp_i + 1][naccel_count][nvel_level] = next_pos;
+                            next_layer_pos[naccel_count][nvel_level] = next_pos;
 
-                            decel_vel(acceled_vel, MAX_VEL_LEVEL);
-                            dp_vel[dp_i + 1][naccel_count][nvel_level] = acceled_vel;
+                            if (corrected)
+                                acceled_vel.reset();
+                            else
+                                decel_vel(acceled_vel, MAX_VEL_LEVEL);
+                            next_layer_vel[naccel_count][nvel_level] = acceled_vel;
 
                             dp_passed_lotus[dp_i + 1][naccel_count][nvel_level] = next_passed_lotus;
-                            dp_prev[dp_i + 1][naccel_count][nvel_level] = pcc(accel_count, vel_level);
-                            dp_action[dp_i + 1][naccel_count][nvel_level] = Action::Accel(cur_target_pos);
+                            dp_prev[dp_i + 1][naccel_count][nvel_level] = pack_cell(accel_count, vel_level);
 
-                            if (next_passed_lotus == lotuses.count() * Parameter::StageRoundCount)
+                            if (next_passed_lotus == goal_lotus)
                                 found_goal = true;
                         }
                     }
@@ -337,13 +499,13 @@ public:
                             passed_lotus > best_passed_lotus ||
                             (
                              passed_lotus == best_passed_lotus &&
-                             dp_pos[searching_turn][accel_count][vel_level].squareDist(target_pos[passed_lotus]) < best_sq_dist
+                             layer_pos[searching_turn & 1][accel_count][vel_level].squareDist(target_pos[passed_lotus]) < best_sq_dist
                             )
                     )
                    )
                 {
                     best_passed_lotus = passed_lotus;
-                    best_sq_dist = dp_pos[searching_turn][accel_count][vel_level].squareDist(target_pos[passed_lotus]);
+                    best_sq_dist = layer_pos[searching_turn & 1][accel_count][vel_level].squareDist(target_pos[passed_lotus]);
                     best_accel_count = accel_count;
                     best_vel_level = vel_level;
                 }
@@ -353,10 +515,13 @@ public:
 
         for (int dp_i = searching_turn, accel_count = best_accel_count, vel_level = best_vel_level; dp_i > 0; --dp_i)
         {
-            cache_action[dp_i - 1] = dp_action[dp_i][accel_count][vel_level];
+            const int paccel_count = cell_accel_count(dp_prev[dp_i][accel_count][vel_level]);
+            const int pvel_level = cell_vel_level(dp_prev[dp_i][accel_count][vel_level]);
+            if (vel_level == MAX_VEL_LEVEL - 1)
+                cache_action[dp_i - 1] = Action::Accel(target_pos[(int)dp_passed_lotus[dp_i - 1][paccel_count][pvel_level]]);
+            else
+                cache_action[dp_i - 1] = Action::Wait();
 
-            int paccel_count = pcc_first(dp_prev[dp_i][accel_count][vel_level]);
-            int pvel_level = pcc_second(dp_prev[dp_i][accel_count][vel_level]);
             assert(0 <= paccel_count && paccel_count <= CharaAccelCountMax);
             assert(0 <= pvel_level && pvel_level <= MAX_VEL_LEVEL);
             accel_count = paccel_count;
@@ -365,6 +530,226 @@ public:
 
         cache_i = 0;
         cache_size = searching_turn;
+        from_segment = false;
+    }
+};
+
+// 2, 3 周目は同じ蓮を同じ順に通過するので、前の周で蓮に入ってから次の蓮を通過するまでに
+// 実行した行動列を、同じ状態で同じ蓮に入った時にそのまま使う
+const int MAX_SEGMENT_TURN = 256;
+const int SEGMENT_SLOT_COUNT = 4; // 蓮ごとに覚えておく行動列の数
+const float SEGMENT_VEL_SCALE = 32; // 速度は 1 / SEGMENT_VEL_SCALE 単位に量子化してキーにする
+const bool USE_SEGMENT_CACHE = true;
+
+struct SegmentKey
+{
+    short vel_x, vel_y;
+    char accel_count;
+    char accel_wait_turn;
+
+    bool operator==(const SegmentKey& other) const
+    {
+        return vel_x == other.vel_x && vel_y == other.vel_y &&
+            accel_count == other.accel_count && accel_wait_turn == other.accel_wait_turn;
+    }
+};
+
+// 加速した (1) か待機した (0) かをターンごとに 1 bit で持つ
+struct Segment
+{
+    SegmentKey key;
+    int size;
+    uint accel_bits[MAX_SEGMENT_TURN / 32];
+
+    bool accel(int turn) const { return accel_bits[turn >> 5] >> (turn & 31) & 1; }
+    void set(int turn, bool accel)
+    {
+        if (accel)
+            accel_bits[turn >> 5] |= 1u << (turn & 31);
+        else
+            accel_bits[turn >> 5] &= ~(1u << (turn & 31));
+    }
+};
+
+// Chara と同じ計算で、state から行動列 segment を再生する
+// state が目指している蓮を通過したらそこまでのターン数を返して state を通過後の状態にする
+// 通過できなければ 0 を返す
+int replay_segment(const StageAccessor& stage_accessor, const Vec2* target_pos, PlanState& state, const Segment& segment, Action* actions)
+{
+    const LotusCollection& lotuses = stage_accessor.lotuses();
+    const Lotus& lotus = lotuses[state.passed_lotus % lotuses.count()];
+    const Vec2& flow_vel = stage_accessor.field().flowVel();
+    const Rectangle& field_rect = stage_accessor.field().rect();
+    const Vec2& target = target_pos[state.passed_lotus];
+    const float hit_dist = lotus.radius() + Parameter::CharaRadius();
+    const float hit_squared_dist = hit_dist * hit_dist;
+
+    Vec2 pos = state.pos;
+    Vec2 vel = state.vel;
+    int accel_count = state.accel_count;
+    int accel_wait_turn = state.accel_wait_turn;
+    rep(turn, segment.size)
+    {
+        if (segment.accel(turn))
+        {
+            if (accel_count == 0 || is_equal(target, pos))
+                return 0;
+            --accel_count;
+            vel = (target - pos).getNormalized(Parameter::CharaAccelSpeed());
+            actions[turn] = Action::Accel(target);
+        }
+        else
+            actions[turn] = Action::Wait();
+
+        const Vec2 prev_pos = pos;
+        pos += vel + flow_vel;
+        decel_vel(vel);
+        if (correct_inside(pos, field_rect))
+            vel.reset();
+        if (--accel_wait_turn <= 0)
+        {
+            accel_count = min(accel_count + 1, CharaAccelCountMax);
+            accel_wait_turn = Parameter::CharaAddAccelWaitTurn;
+        }
+
+        if (swept_hit(lotus.pos(), hit_squared_dist, prev_pos, pos))
+        {
+            state.pos = pos;
+            state.vel = vel;
+            state.accel_count = accel_count;
+            state.accel_wait_turn = accel_wait_turn;
+            ++state.passed_lotus;
+            return turn + 1;
+        }
+    }
+    return 0;
+}
+
+struct SegmentCacheStats
+{
+    int stored;
+    int lookups;
+    int hits;
+
+    SegmentCacheStats() { reset(); }
+    void reset() { stored = lookups = hits = 0; }
+};
+
+class PlanSegmentCache
+{
+public:
+    void init(const StageAccessor& stage_accessor)
+    {
+        lotus_count = stage_accessor.lotuses().count();
+        rep(lotus, lotus_count)
+        {
+            rep(slot, SEGMENT_SLOT_COUNT)
+                segments[lotus][slot].size = 0;
+            next_slot[lotus] = 0;
+        }
+        recording_passed_lotus = -1;
+        recording_valid = false;
+        just_entered = false;
+        cache_stats.reset();
+    }
+
+    const SegmentCacheStats& stats() const { return cache_stats; }
+
+    // 蓮を通過した直後のターンか
+    bool entered() const { return just_entered; }
+
+    // 毎ターン、行動を決める前に呼ぶ
+    // predicted: 前のターンの予測どおりの位置にいるか (他のキャラとの衝突がなかったか)
+    void observe(const Chara& player, bool predicted)
+    {
+        if (!predicted)
+            recording_valid = false;
+
+        just_entered = player.passedLotusCount() != recording_passed_lotus;
+        if (!just_entered)
+            return;
+
+        if (recording_valid && recording.size > 0 && player.passedLotusCount() == recording_passed_lotus + 1)
+            store(recording_passed_lotus % lotus_count, recording);
+
+        recording_passed_lotus = player.passedLotusCount();
+        recording_valid = true;
+        recording.key = make_key(player);
+        recording.size = 0;
+    }
+
+    // 実行する行動を記録する
+    void record(const Action& action)
+    {
+        if (!recording_valid)
+            return;
+        if (recording.size == MAX_SEGMENT_TURN)
+        {
+            recording_valid = false;
+            return;
+        }
+        recording.set(recording.size++, action.type() == ActionType_Accel);
+    }
+
+    // 現在の状態から前の周の行動列を再生して、目指している蓮を通過できるものを actions に入れる
+    // 返り値は行動列の長さで、見つからなければ 0
+    int find(const StageAccessor& stage_accessor, const Vec2* target_pos, Action* actions)
+    {
+        const Chara& player = stage_accessor.player();
+        const int lotus = player.passedLotusCount() % lotus_count;
+        const SegmentKey key = make_key(player);
+
+        ++cache_stats.lookups;
+        rep(slot, SEGMENT_SLOT_COUNT)
+        {
+            const Segment& segment = segments[lotus][slot];
+            if (segment.size == 0 || !(segment.key == key))
+                continue;
+
+            // 量子化したキーが一致しても位置や速度は少し違うので、実際に蓮を通過できるかを確かめる
+            PlanState state(player);
+            const int size = replay_segment(stage_accessor, target_pos, state, segment, actions);
+            if (size > 0)
+            {
+                ++cache_stats.hits;
+                return size;
+            }
+        }
+        return 0;
+    }
+
+private:
+    int lotus_count;
+    Segment segments[Parameter::LotusCountMax][SEGMENT_SLOT_COUNT];
+    int next_slot[Parameter::LotusCountMax];
+
+    Segment recording;
+    int recording_passed_lotus;
+    bool recording_valid;
+    bool just_entered;
+
+    SegmentCacheStats cache_stats;
+
+    static SegmentKey make_key(const Chara& player)
+    {
+        SegmentKey key;
+        key.vel_x = (short)Math::Ceil(player.vel().x * SEGMENT_VEL_SCALE - 0.5f);
+        key.vel_y = (short)Math::Ceil(player.vel().y * SEGMENT_VEL_SCALE - 0.5f);
+        key.accel_count = player.accelCount();
+        key.accel_wait_turn = player.accelWaitTurn();
+        return key;
+    }
+
+    void store(int lotus, const Segment& segment)
+    {
+        rep(slot, SEGMENT_SLOT_COUNT)
+        {
+            if (segments[lotus][slot].size > 0 && segments[lotus][slot].key == segment.key)
+                return;
+        }
+        segments[lotus][next_slot[lotus]] = segment;
+        next_slot[lotus] = (next_slot[lotus] + 1) % SEGMENT_SLOT_COUNT;
+        ++cache_stats.stored;
     }
 };
 }
@@ -373,27 +758,23 @@ namespace hpc
 {
 using namespace solver;
 
-int cc = 0;
-
 int stage_no = -1;
 
 ActionStrategy action_strategy;
-Vec2 target_pos[Parameter::LotusCountMax * Parameter::StageRoundCount];
+PlanSegmentCache segment_cache;
+SearchPace search_pace;
+Vec2 target_pos[Parameter::LotusCountMax * Parameter::StageRoundCount + 1];
 
 int prev;
 Vec2 next_predicted_pos;
 void Answer::Init(const StageAccessor& aStageAccessor)
 {
     ++stage_no;
-//     dump(stage_no);
-//     if (stage_no > 0)
-//         exit(0);
-//     dump(cc);
-    cc = 0;
 
     search_path(aStageAccessor, target_pos);
 
     action_strategy.reset();
+    segment_cache.init(aStageAccessor);
     prev = 0;
     next_predicted_pos = Vec2(1919, 810);
 }
@@ -401,15 +782,45 @@ void Answer::Init(const StageAccessor& aStageAccessor)
 Action Answer::GetNextAction(const StageAccessor& aStageAccessor)
 {
     const Chara& player = aStageAccessor.player();
+    const TimeBudget& budget = aStageAccessor.timeBudget();
+    ++search_pace.turns;
+
+    SolverStats& solver_stats = SolverStats::Current();
+    const bool predicted = player.passedTurn() == 0 || is_equal(player.pos(), next_predicted_pos);
+    if (!predicted)
+        solver_stats.writeDeviation(player.pos().dist(next_predicted_pos));
 
-    if (player.passedTurn() > 0 && !is_equal(player.pos(), next_predicted_pos))
-        ++cc;
+    segment_cache.observe(player, predicted);
 
-    if (action_strategy.index() + 1 >= action_strategy.size() * 6 / 10 ||
-        !is_equal(player.pos(), next_predicted_pos))
+    // 2 周目以降は蓮に入るたびに前の周の行動列を使えるか調べる
+    static Action segment_actions[MAX_SEGMENT_TURN];
+    int segment_size = 0;
+    if (USE_SEGMENT_CACHE && segment_cache.entered() && player.passedLotusCount() >= aStageAccessor.lotuses().count())
+        segment_size = segment_cache.find(aStageAccessor, target_pos, segment_actions);
+
+    if (segment_size > 0)
+    {
+        solver_stats.writeSegmentHit();
+        action_strategy.load_segment(segment_actions, segment_size);
+    }
+    // ステージに割り当てられた時間を使い切ったら、計画を最後まで使ってから探索し直す
+    else if (action_strategy.index() + 1 >= (budget.isStageOver() ? action_strategy.size() : action_strategy.replan_size()) ||
+        !is_equal(player.pos(), next_predicted_pos) ||
+        (segment_cache.entered() && action_strategy.segment_plan()))
     {
-        int search_turns = MAX_SEARCH_TURN - 1;
+        int search_turns = search_pace.depth(budget, player.passedTurn());
         int rem_accel_count = 0;
+        const SearchStats prev_stats = action_strategy.stats();
+        // 探索し直す理由を、ステージ開始、位置のずれ、再利用した行動列の終わり、計画の消化の順に判定する
+        ReplanReason reason = ReplanReason_Threshold;
+        if (player.passedTurn() == 0)
+            reason = ReplanReason_Initial;
+        else if (!predicted)
+            reason = ReplanReason_Deviation;
+        else if (segment_cache.entered() && action_strategy.segment_plan())
+            reason = ReplanReason_Segment;
+        solver_stats.writeReplan(reason);
+        solver_stats.beginSearch();
 //         if (player.passedTurn() - prev <= 5)
 //         {
 //             search_turns = MAX_SEARCH_TURN / 2;
@@ -419,6 +830,8 @@ Action Answer::GetNextAction(const StageAccessor& aStageAccessor)
 
 //         rem_accel_count = solver::min(solver::max(0, player.accelCount() - 3), 1);
         action_strategy.search(aStageAccessor, target_pos, search_turns, rem_accel_count);
+        const SearchStats& stats = action_strategy.stats();
+        solver_stats.endSearch(action_strategy.size(), stats.expanded_cells - prev_stats.expanded_cells);
         prev = player.passedTurn();
     }
     else
@@ -429,15 +842,18 @@ Action Answer::GetNextAction(const StageAccessor& aStageAccessor)
     }
 
     Action action = action_strategy.get_action();
+    segment_cache.record(action);
     if (action.type() == ActionType_Accel)
     {
         next_predicted_pos = player.pos();
         next_predicted_pos += (action.value() - player.pos()).getNormalized(Parameter::CharaAccelSpeed()) + aStageAccessor.field().flowVel();
+        correct_inside(next_predicted_pos, aStageAccessor.field().rect());
     }
     else
     {
         Chara p = player;
         p.move();
+        p.correctInside();
         next_predicted_pos = p.pos();
     }
 
@@ -15,6 +15,9 @@
 #include "HPCAnswer.hpp"
 #include "HPCCollision.hpp"
 #include "HPCMath.hpp"
+#include "HPCPerfCounter.hpp"
+#include "HPCSolverStats.hpp"
+#include "HPCTracer.hpp"
 
 //------------------------------------------------------------------------------
 // EOF
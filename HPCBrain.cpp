@@ -18,11 +18,17 @@
 #include "HPCParameter.hpp"
 #include "HPCRandom.hpp"
 #include "HPCStageAccessor.hpp"
+#include "HPCTimeBudget.hpp"
+#include "HPCTracer.hpp"
 
 namespace {
     using namespace hpc;
     
     const int CpuSaveAccelTurnMax = 2;
+
+    // 複数のスレッドで別々のステージを再シミュレーションできるよう、スレッドごとに持つ。
+    HPC_THREAD_LOCAL const Action* sReplayActions = 0;  ///< 人間キャラに与える動作の記録。 0 なら Answer が決定する
+    HPC_THREAD_LOCAL int sReplayActionCount = 0;        ///< 記録された動作の数
 }
 
 namespace hpc {
@@ -36,6 +42,23 @@ namespace hpc {
         reset();
     }
     
+    //------------------------------------------------------------------------------
+    /// 人間キャラの動作を、 Answer の代わりに記録された動作列から与えます。
+    /// リプレイの再シミュレーションに使用します。
+    ///
+    /// 設定している間は Answer::Init と Answer::GetNextAction は呼ばれず、
+    /// 経過ターン数番目の動作を返します。記録が尽きた場合は待機します。
+    ///
+    /// 設定は呼び出したスレッドでのみ有効です。
+    ///
+    /// @param[in] aActions 各ターンの動作。 0 を指定すると Answer を呼ぶ通常の動作に戻ります。
+    /// @param[in] aCount   動作の数。
+    void Brain::SetReplayActions(const Action* aActions, int aCount)
+    {
+        sReplayActions = aActions;
+        sReplayActionCount = aCount;
+    }
+
     //------------------------------------------------------------------------------
     /// 状態をリセットします。
     void Brain::reset()
@@ -63,7 +86,12 @@ namespace hpc {
         case CharaType_Human:
             // Answer::Init でプレイヤーの初期状態を参照できるようにします。
             // 但し、Init でステージの状態を書き換えることはできません。
-            Answer::Init(aStageAccessor);
+            // 時間の割り当ては、解答プログラムの呼び出しの間だけを計測します。
+            if (!sReplayActions) {
+                TimeBudget::Current().beginAnswer();
+                Answer::Init(aStageAccessor);
+                TimeBudget::Current().endAnswer();
+            }
             break;
 
         case CharaType_Cpu:
@@ -90,7 +118,17 @@ namespace hpc {
     {
         switch (mCharaParam.type()) {
         case CharaType_Human:
-            return Answer::GetNextAction(aStageAccessor);
+            if (sReplayActions) {
+                const int turn = aStageAccessor.player().passedTurn();
+                return turn < sReplayActionCount ? sReplayActions[turn] : Action::Wait();
+            }
+            {
+                TraceScope traceScope("Answer::GetNextAction");
+                TimeBudget::Current().beginAnswer();
+                const Action action = Answer::GetNextAction(aStageAccessor);
+                TimeBudget::Current().endAnswer();
+                return action;
+            }
 
         case CharaType_Cpu:
             return getCpuNextAction(aStageAccessor, aRandom);
@@ -25,6 +25,8 @@ namespace hpc {
     public:
         Brain();
 
+        static void SetReplayActions(const Action* aActions, int aCount); ///< 人間キャラの動作を記録から与えます。
+
         void reset();                                       ///< リセットします。
         void setup(const CharaParam& aCharaParam);          ///< 初期状態を設定します。
         
@@ -26,6 +26,7 @@ namespace hpc {
         , mRegion(Vec2(), Parameter::CharaRadius())
         , mPrevRegion(Vec2(), Parameter::CharaRadius())
         , mDecidedAction()
+        , mLastAction()
         , mVel()
         , mAccelCount(0)
         , mAccelWaitTurn(0)
@@ -48,6 +49,17 @@ namespace hpc {
         mBrain.init(mStageAccessor);
     }
 
+    //------------------------------------------------------------------------------
+    /// 参照するステージだけを設定し直します。 init と異なり、動作決定モジュールの準備処理は行いません。
+    /// ステージを複製した後に、複製先を参照させるために使います。
+    ///
+    /// @param[in] aStage       参照するステージ。
+    /// @param[in] aCharaIndex  ステージ内でのキャラの番号。
+    void Chara::bindStage(const Stage& aStage, int aCharaIndex)
+    {
+        mStageAccessor.init(aStage, aCharaIndex);
+    }
+
     //------------------------------------------------------------------------------
     /// 動作を決定します。
     void Chara::decideAction(Random& aRandom)
@@ -78,6 +90,7 @@ namespace hpc {
         }
         
         // 実行済みActionをリセットしておく
+        mLastAction = mDecidedAction;
         mDecidedAction.reset();
     }
 
@@ -162,6 +175,7 @@ namespace hpc {
         mRegion.setPos(hpc::Vec2());
         mPrevRegion.setPos(hpc::Vec2());
         mBrain.reset();
+        mLastAction.reset();
         mVel.reset();
         mAccelCount = Parameter::CharaInitAccelCount;
         mAccelWaitTurn = Parameter::CharaAddAccelWaitTurn;
@@ -299,6 +313,13 @@ namespace hpc {
         return mPassedTurn;
     }
 
+    //------------------------------------------------------------------------------
+    /// @return execAction で最後に実行した動作。加速できなかった場合も、決定された動作を返します。
+    const Action& Chara::lastAction()const
+    {
+        return mLastAction;
+    }
+
     //------------------------------------------------------------------------------
     /// キャラの前回領域を表す円を返します。
     ///
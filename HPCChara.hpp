@@ -28,6 +28,7 @@ namespace hpc {
         Chara();
 
         void init(const Stage& aStage, int aCharaIndex);    ///< 準備処理を行います。
+        void bindStage(const Stage& aStage, int aCharaIndex); ///< 参照するステージだけを設定し直します。
         void decideAction(Random& aRandom);                 ///< 動作を決定します。
         void execAction();                                  ///< 動作を実行します。
         void move();                                        ///< 移動処理を行います。
@@ -52,6 +53,7 @@ namespace hpc {
         int rank()const;                                    ///< 順位を返します。
         int passedLotusCount()const;                        ///< 通過した蓮の数を返します。
         int passedTurn()const;                              ///< 経過ターン数を返します。
+        const Action& lastAction()const;                    ///< 最後に実行した動作を返します。
         
         const Circle& prevRegion()const;                    ///< 前回領域を表す円を返します。
 
@@ -61,6 +63,7 @@ namespace hpc {
         Circle mRegion;                 ///< 領域
         Circle mPrevRegion;             ///< 前回領域
         Action mDecidedAction;          ///< 決定された動作
+        Action mLastAction;             ///< 最後に実行した動作
         Vec2 mVel;                      ///< 速度
         int mAccelCount;                ///< 加速できる回数
         int mAccelWaitTurn;             ///< 加速回数が増えるまでの残りターン数
@@ -13,6 +13,7 @@
 
 #include "HPCCollision.hpp"
 #include "HPCCommon.hpp"
+#include "HPCPerfCounter.hpp"
 #include "HPCStage.hpp"
 
 namespace {
@@ -134,6 +135,8 @@ namespace hpc {
     /// 各キャラ同士の衝突判定を行います。
     void CharaCollection::procCheckColl()
     {
+        PerfScope perfScope(PerfRegion_CheckColl);
+
         // ■衝突判定の方針について
         // 条件：静止円同士での判定。非弾性衝突。処理順に影響しない。
         // 
@@ -0,0 +1,199 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCCheckpoint.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCCheckpoint.hpp"
+
+#include "HPCBrain.hpp"
+#include "HPCCommon.hpp"
+#include "HPCMath.hpp"
+#include "HPCReplay.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    ///
+    /// @note 生成しただけでは保存しません。 setInterval 関数で保存間隔を設定する必要があります。
+    CheckpointStore::CheckpointStore()
+        : mEntries()
+        , mFirstEntries()
+        , mEntryCounts()
+        , mCount(0)
+        , mInterval(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 保存間隔を設定します。ゲームを開始する前に呼び出します。
+    ///
+    /// @param[in] aInterval 保存間隔 [ターン] 。 0 の場合は保存しません。
+    void CheckpointStore::setInterval(int aInterval)
+    {
+        HPC_ASSERT(0 <= aInterval);
+        mInterval = aInterval;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 保存間隔 [ターン] 。
+    int CheckpointStore::interval()const
+    {
+        return mInterval;
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージの開始時と各ターンの終了時に呼び出します。
+    /// 保存間隔で割り切れるターンであれば、ステージとゲーム用乱数の状態を保存します。
+    ///
+    /// @param[in] aStageIndex ステージ番号。ステージ番号の順に呼び出す必要があります。
+    /// @param[in] aTurn       実行したターン数。ステージ開始時は 0 です。
+    /// @param[in] aStage      実行中のステージ。
+    /// @param[in] aGame       ゲーム用乱数。次のターンで使う状態である必要があります。
+    void CheckpointStore::write(int aStageIndex, int aTurn, const Stage& aStage, const Random& aGame)
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        if (aTurn == 0) {
+            mFirstEntries[aStageIndex] = mCount;
+            mEntryCounts[aStageIndex] = 0;
+        }
+        if (mInterval <= 0 || aTurn % mInterval != 0 || mCount >= CapacityMax) {
+            return;
+        }
+        Entry& entry = mEntries[mCount++];
+        entry.stage.set(aStage);
+        entry.gameSeed[0] = aGame.seedX();
+        entry.gameSeed[1] = aGame.seedY();
+        ++mEntryCounts[aStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 保存した数。
+    int CheckpointStore::count()const
+    {
+        return mCount;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 保存に使っているメモリの量 [byte] 。
+    int CheckpointStore::byteSize()const
+    {
+        return mCount * static_cast<int>(sizeof(Entry));
+    }
+
+    //------------------------------------------------------------------------------
+    /// 指定ターン以前で最も近い保存を探し、その状態を複製します。
+    ///
+    /// @param[in]  aStageIndex ステージ番号。
+    /// @param[in]  aTurn       ターン。
+    /// @param[out] aStage      保存していたステージの複製先。
+    /// @param[out] aGame       保存していたゲーム用乱数の複製先。
+    ///
+    /// @return 見つかった保存のターン。見つからなかった場合は -1 。
+    int CheckpointStore::find(int aStageIndex, int aTurn, Stage& aStage, Random& aGame)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        if (mInterval <= 0 || mEntryCounts[aStageIndex] == 0) {
+            return -1;
+        }
+        // 保存は間隔ごとに欠けなく並んでいるので、位置を計算で求められる。
+        const int entryIndex = Math::Min(aTurn / mInterval, mEntryCounts[aStageIndex] - 1);
+        const Entry& entry = mEntries[mFirstEntries[aStageIndex] + entryIndex];
+        aStage.set(entry.stage);
+        aGame = Random(entry.gameSeed[0], entry.gameSeed[1]);
+        return entryIndex * mInterval;
+    }
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    TurnSeeker::TurnSeeker()
+        : mStage()
+        , mGame(0, 0)
+        , mStageIndex(-1)
+        , mTurn(0)
+        , mResimulatedTurnCount(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 指定ターン以前で最も近い保存から、リプレイの動作で指定ターンまで再シミュレーションします。
+    ///
+    /// 同じステージで現在より後のターンへ移動する場合は、保存からではなく現在の状態から進めます。
+    /// ステージが指定ターンより前に終わっている場合は、終了したターンに移動します。
+    ///
+    /// @param[in] aCheckpoints 保存した状態。
+    /// @param[in] aReplay      ステージのリプレイ。
+    /// @param[in] aTurn        移動するターン。 0 がステージ開始時の状態です。
+    ///
+    /// @return 移動できた場合は @c true 。
+    bool TurnSeeker::seek(
+        const CheckpointStore& aCheckpoints
+        , const ReplayStage& aReplay
+        , int aTurn
+        )
+    {
+        const int stageIndex = aReplay.stageIndex();
+        const int target = Math::LimitMinMax(aTurn, 0, aReplay.turnCount());
+        // 現在の状態が、目的のターンに最も近い保存よりも近ければ、そのまま進める。
+        const int interval = Math::Max(aCheckpoints.interval(), 1);
+        const bool isForward = stageIndex == mStageIndex && target - target % interval <= mTurn && mTurn <= target;
+        if (!isForward) {
+            mStageIndex = -1;
+            mTurn = aCheckpoints.find(stageIndex, target, mStage, mGame);
+            if (mTurn < 0) {
+                mTurn = 0;
+                return false;
+            }
+            mStageIndex = stageIndex;
+        }
+
+        // 保存した時点の記録レベルによらず、位置を得られるようにする。
+        mStage.setRecordLevel(RecordLevel_Full);
+        Brain::SetReplayActions(aReplay.actions(), aReplay.turnCount());
+        mResimulatedTurnCount = 0;
+        while (mTurn < target && mStage.lastTurnResult().state == StageState_Playing) {
+            mStage.runTurn(mGame);
+            ++mTurn;
+            ++mResimulatedTurnCount;
+        }
+        Brain::SetReplayActions(0, 0);
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 移動したステージ番号。移動していない場合は -1 。
+    int TurnSeeker::stageIndex()const
+    {
+        return mStageIndex;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 移動したターン。
+    int TurnSeeker::turn()const
+    {
+        return mTurn;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 直前の seek で再シミュレーションしたターン数。
+    int TurnSeeker::resimulatedTurnCount()const
+    {
+        return mResimulatedTurnCount;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 移動したターンのステージ。
+    const Stage& TurnSeeker::stage()const
+    {
+        HPC_ASSERT(0 <= mStageIndex);
+        return mStage;
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
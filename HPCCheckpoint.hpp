@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    CheckpointStore, TurnSeeker クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "HPCParameter.hpp"
+#include "HPCRandom.hpp"
+#include "HPCStage.hpp"
+#include "HPCTypes.hpp"
+
+namespace hpc {
+
+    class ReplayStage;
+
+    //------------------------------------------------------------------------------
+    /// @brief 実行中のステージの状態を、一定ターンごとに保存します。
+    ///
+    /// 保存する間隔を短くするとメモリを多く使い、 TurnSeeker での移動が速くなります。
+    /// 保存先は全ステージで共有する固定の領域で、一杯になるとそれ以降は保存しません。
+    /// その場合も、手前の保存からの再シミュレーションになるだけで、結果は変わりません。
+    /// 既定では保存しません。デバッガを使う場合だけ setInterval で間隔を設定します。
+    class CheckpointStore
+    {
+    public:
+        static const int DefaultInterval = 64;              ///< デバッガを使う場合の既定の保存間隔 [ターン]
+        static const int CapacityMax = 8192;                ///< 保存できる数
+
+        CheckpointStore();
+
+        void setInterval(int aInterval);                    ///< 保存間隔を設定します。 0 なら保存しません。
+        int interval()const;                               ///< 保存間隔を返します。
+        void write(int aStageIndex, int aTurn, const Stage& aStage, const Random& aGame); ///< 保存間隔のターンであれば状態を保存します。
+
+        int count()const;                                  ///< 保存した数を返します。
+        int byteSize()const;                               ///< 保存に使っているメモリの量を返します。
+        /// 指定ターン以前で最も近い保存を探します。
+        int find(int aStageIndex, int aTurn, Stage& aStage, Random& aGame)const;
+
+    private:
+        /// 保存した状態
+        struct Entry
+        {
+            Stage stage;        ///< ステージ
+            uint gameSeed[2];   ///< ゲーム用乱数の状態
+        };
+
+        Entry mEntries[CapacityMax];                        ///< 保存先
+        int mFirstEntries[Parameter::GameStageCount];      ///< ステージごとの最初の保存の位置
+        int mEntryCounts[Parameter::GameStageCount];       ///< ステージごとの保存の数
+        int mCount;                                         ///< 保存した数
+        int mInterval;                                      ///< 保存間隔 [ターン]
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief 保存した状態から再シミュレーションして、ステージの任意のターンに移動します。
+    ///
+    /// プレイヤーの動作はリプレイから与えるため、 Answer は呼び出されません。
+    class TurnSeeker
+    {
+    public:
+        TurnSeeker();
+
+        /// 指定ターンに移動します。
+        bool seek(
+            const CheckpointStore& aCheckpoints
+            , const ReplayStage& aReplay
+            , int aTurn
+            );
+
+        int stageIndex()const;                             ///< 移動したステージ番号を返します。
+        int turn()const;                                   ///< 移動したターンを返します。
+        int resimulatedTurnCount()const;                   ///< 直前の移動で再シミュレーションしたターン数を返します。
+        const Stage& stage()const;                         ///< 移動したターンのステージを返します。
+
+    private:
+        Stage mStage;                                       ///< 再シミュレーションするステージ
+        Random mGame;                                       ///< ゲーム用乱数
+        int mStageIndex;                                    ///< ステージ番号
+        int mTurn;                                          ///< 現在のターン
+        int mResimulatedTurnCount;                          ///< 直前の移動で再シミュレーションしたターン数
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
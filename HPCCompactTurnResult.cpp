@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCCompactTurnResult.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCCompactTurnResult.hpp"
+
+#include "HPCCommon.hpp"
+#include "HPCMath.hpp"
+
+namespace {
+
+    //------------------------------------------------------------------------------
+    /// 座標を 0.001 単位の値に変換します。
+    ///
+    /// @param[in]  aValue  座標。フィールド内の値である必要があります。
+    /// @param[out] aIsUp   小数第 2 位へ丸めたときに、0.001 単位の値の 1 の位が 5 のまま
+    ///                     切り上がる場合に @c true 。
+    ///
+    /// @return 0.001 単位の値。
+    unsigned short EncodePos(float aValue, bool& aIsUp)
+    {
+        // float の値に 1000 や 100 を掛けても double では誤差は生じない。
+        const double milli = hpc::Math::RoundHalfEven(static_cast<double>(aValue) * 1000.0);
+        const double centi = hpc::Math::RoundHalfEven(static_cast<double>(aValue) * 100.0);
+        HPC_RANGE_ASSERT_MIN_MAX_I(static_cast<int>(milli), 0, 0xFFFF);
+        aIsUp = centi * 10.0 > milli;
+        return static_cast<unsigned short>(milli);
+    }
+
+    //------------------------------------------------------------------------------
+    /// EncodePos で変換した値を座標に戻します。
+    ///
+    /// 1 の位が 5 の場合は、小数第 2 位への丸めの向きが元の値と同じになるようにずらします。
+    float DecodePos(unsigned short aMilli, bool aIsUp)
+    {
+        double milli = aMilli;
+        if (aMilli % 10 == 5) {
+            milli += aIsUp ? 0.125 : -0.125;
+        }
+        return static_cast<float>(milli / 1000.0);
+    }
+}
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    ///
+    /// @note RecordStage は全ターン分を確保するので、ここでは値を設定しません。
+    ///       RecordLevel_Full 未満では encode されず、確保した領域に触れずに済みます。
+    ///       読み出すのは encode したターンだけです。
+    CompactTurnResult::CompactTurnResult()
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// TurnResult の値を詰めて保持します。
+    ///
+    /// @param[in] aResult 保持する値。
+    void CompactTurnResult::encode(const TurnResult& aResult)
+    {
+        uint packed = static_cast<uint>(aResult.state) << 24;
+        for (int index = 0; index < Parameter::CharaCountMax; ++index) {
+            const TurnResult::Chara& chara = aResult.charas[index];
+            bool isUpX = false;
+            bool isUpY = false;
+            mPosX[index] = EncodePos(chara.pos.x, isUpX);
+            mPosY[index] = EncodePos(chara.pos.y, isUpY);
+            HPC_RANGE_ASSERT_MIN_MAX_I(chara.accelCount, 0, 0xF);
+            HPC_RANGE_ASSERT_MIN_MAX_I(chara.passedLotusCount, 0, 0xFF);
+            mPassedLotusCounts[index] = static_cast<unsigned char>(chara.passedLotusCount);
+            packed |= static_cast<uint>(chara.accelCount) << (index * 4);
+            packed |= (isUpX ? 1u : 0u) << (16 + index * 2);
+            packed |= (isUpY ? 1u : 0u) << (17 + index * 2);
+        }
+        mPacked = packed;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 保持している値を TurnResult に復元します。
+    ///
+    /// @param[out] aResult 復元先。
+    void CompactTurnResult::decode(TurnResult& aResult)const
+    {
+        for (int index = 0; index < Parameter::CharaCountMax; ++index) {
+            TurnResult::Chara& chara = aResult.charas[index];
+            chara.pos.x = DecodePos(mPosX[index], ((mPacked >> (16 + index * 2)) & 1) != 0);
+            chara.pos.y = DecodePos(mPosY[index], ((mPacked >> (17 + index * 2)) & 1) != 0);
+            chara.accelCount = static_cast<int>((mPacked >> (index * 4)) & 0xF);
+            chara.passedLotusCount = mPassedLotusCounts[index];
+        }
+        aResult.state = static_cast<StageState>((mPacked >> 24) & 0x7);
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,43 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    CompactTurnResult クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "HPCParameter.hpp"
+#include "HPCTurnResult.hpp"
+#include "HPCTypes.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief TurnResult を記録用に詰めて保持します。
+    ///
+    /// 位置は 0.001 単位の固定小数点 (16 bit)、加速回数は 4 bit、通過した蓮の数は 8 bit で保持します。
+    /// 復元した値を %7.3f と %7.2f で表示すると、元の値を表示した場合と同じ文字列になります。
+    class CompactTurnResult
+    {
+    public:
+        CompactTurnResult();
+
+        void encode(const TurnResult& aResult);             ///< TurnResult を詰めて保持します。
+        void decode(TurnResult& aResult)const;             ///< 保持している値を TurnResult に復元します。
+
+    private:
+        unsigned short mPosX[Parameter::CharaCountMax];     ///< x 座標 [0.001 単位]
+        unsigned short mPosY[Parameter::CharaCountMax];     ///< y 座標 [0.001 単位]
+        unsigned char mPassedLotusCounts[Parameter::CharaCountMax]; ///< 通過した蓮の数
+        /// bit 0-15 : 加速回数 (4 bit ずつ)
+        /// bit 16-23: 小数第 2 位への丸めで切り上がるか (キャラごとに x, y の 2 bit)
+        /// bit 24-26: 状態
+        uint mPacked;
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
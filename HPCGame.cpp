@@ -13,6 +13,29 @@
 
 #include "HPCCommon.hpp"
 #include "HPCLevelDesigner.hpp"
+#include "HPCPerfCounter.hpp"
+#include "HPCTracer.hpp"
+
+namespace {
+
+    //------------------------------------------------------------------------------
+    /// リプレイの記録先を返します。
+    /// リプレイを使う場合だけ構築されるよう関数内の static 変数とする。
+    hpc::Replay& ReplayStorage()
+    {
+        static hpc::Replay sReplay;
+        return sReplay;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 状態の保存先を返します。
+    /// 保存先は数 MB あるので、デバッガを使う場合だけ構築されるよう関数内の static 変数とする。
+    hpc::CheckpointStore& CheckpointStorage()
+    {
+        static hpc::CheckpointStore sStore;
+        return sStore;
+    }
+}
 
 namespace hpc {
 
@@ -25,7 +48,48 @@ namespace hpc {
         , mStage()
         , mCurrentStageIndex(0)
         , mRecord()
+        , mReplay(0)
+        , mCheckpoints(0)
+        , mStagePipeline()
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 記録レベルを設定します。ゲームを開始する前に呼び出します。
+    ///
+    /// @param[in] aLevel 記録レベル。
+    void Game::setRecordLevel(RecordLevel aLevel)
     {
+        mStage.setRecordLevel(aLevel);
+        mRecord.setLevel(aLevel);
+        mStagePipeline.setRecordLevel(aLevel);
+    }
+
+    //------------------------------------------------------------------------------
+    /// リプレイを記録するかを設定します。ゲームを開始する前に呼び出します。
+    ///
+    /// 設定しなければ記録先を用意せず、ターンごとの記録も行いません。
+    ///
+    /// @param[in] aIsEnabled 記録する場合は @c true 。
+    void Game::setReplayEnabled(bool aIsEnabled)
+    {
+        mReplay = aIsEnabled ? &ReplayStorage() : 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージの状態を保存する間隔を設定します。ゲームを開始する前に呼び出します。
+    ///
+    /// 設定しなければ保存先を用意せず、保存も行いません。
+    /// 保存した状態からの移動にはリプレイを使うので、 setReplayEnabled も設定する必要があります。
+    ///
+    /// @param[in] aInterval 保存間隔 [ターン] 。 0 の場合は保存しません。
+    void Game::setCheckpointInterval(int aInterval)
+    {
+        HPC_ASSERT(0 <= aInterval);
+        mCheckpoints = 0 < aInterval ? &CheckpointStorage() : 0;
+        if (mCheckpoints) {
+            mCheckpoints->setInterval(aInterval);
+        }
     }
 
     //------------------------------------------------------------------------------
@@ -36,10 +100,36 @@ namespace hpc {
     {
         HPC_ASSERT_MSG(isValidStage(), "Index indicates an invalid Stage (#%d)", mCurrentStageIndex);
         
+        Tracer::Begin("Stage", mCurrentStageIndex);
+
         // ステージの生成を行います。
-        LevelDesigner::Setup(mCurrentStageIndex, mStage, mRandSet.system());
+        PerfCounter::SetStage(mCurrentStageIndex);
+        // 通常は前のステージを実行している間に生成スレッドで生成を済ませておき、ここでは取り出すだけにします。
+        // ハードウェアカウンタはスレッドごとに計測するため、計測中はこのスレッドで生成します。
+        if (mCurrentStageIndex == 0 && !PerfCounter::IsEnabled()) {
+            mStagePipeline.start(mRandSet.system());
+        }
+        if (mStagePipeline.isRunning()) {
+            uint systemSeed[2];
+            mStagePipeline.take(mCurrentStageIndex, mStage, systemSeed);
+            if (mReplay) {
+                // 生成前の乱数の状態をリプレイに残します。
+                mReplay->stage(mCurrentStageIndex).writeStart(mCurrentStageIndex, Random(systemSeed[0], systemSeed[1]), mRandSet.game());
+            }
+        } else {
+            if (mReplay) {
+                // 生成前の乱数の状態をリプレイに残します。
+                mReplay->stage(mCurrentStageIndex).writeStart(mCurrentStageIndex, mRandSet.system(), mRandSet.game());
+            }
+            LevelDesigner::Setup(mCurrentStageIndex, mStage, mRandSet.system());
+        }
 
+        // 解答プログラムの統計情報はステージごとに集計します。
+        SolverStats::Current().reset();
         mStage.start();
+        if (mCheckpoints) {
+            mCheckpoints->write(mCurrentStageIndex, 0, mStage, mRandSet.game());
+        }
         mRecord.writeStartStage(mCurrentStageIndex, mStage);
         mRecord.writeTurn(mStage.lastTurnResult());
     }
@@ -52,8 +142,16 @@ namespace hpc {
     {
         HPC_ASSERT_MSG(isValidStage(), "Index indicates an invalid Stage (#%d)", mCurrentStageIndex);
 
+        Tracer::Begin("Turn");
         mStage.runTurn(mRandSet.game());
+        Tracer::End("Turn");
         mRecord.writeTurn(mStage.lastTurnResult());
+        if (mReplay) {
+            mReplay->stage(mCurrentStageIndex).writeTurn(mStage);
+        }
+        if (mCheckpoints) {
+            mCheckpoints->write(mCurrentStageIndex, mStage.charas()[0].passedTurn(), mStage, mRandSet.game());
+        }
     }
 
     //------------------------------------------------------------------------------
@@ -76,6 +174,11 @@ namespace hpc {
     {
         HPC_ASSERT_MSG(isValidStage(), "Index indicates an invalid Stage (#%d)", mCurrentStageIndex);
         mRecord.writeEndStage(mStage);
+        if (mReplay) {
+            mReplay->stage(mCurrentStageIndex).writeEnd(mStage);
+            mReplay->setStageCount(mCurrentStageIndex + 1);
+        }
+        Tracer::End("Stage");
         ++mCurrentStageIndex;
     }
 
@@ -92,6 +195,15 @@ namespace hpc {
         return (0 <= mCurrentStageIndex && mCurrentStageIndex < Parameter::GameStageCount);
     }
 
+    //------------------------------------------------------------------------------
+    /// 現在のステージ番号を返します。
+    ///
+    /// @note すべてのステージを終えた場合は、最終ステージのインデックスに 1 加えた値を返します。
+    int Game::stageIndex()const
+    {
+        return mCurrentStageIndex;
+    }
+
     //------------------------------------------------------------------------------
     /// 内部に格納されているゲームの記録を返します。
     ///
@@ -100,6 +212,26 @@ namespace hpc {
     {
         return mRecord;
     }
+
+    //------------------------------------------------------------------------------
+    /// 内部に格納されているゲームのリプレイを返します。
+    ///
+    /// @return 終了したステージまでのリプレイを表す @c Replay クラスへの const 参照を返します。
+    ///         記録していない場合は、ステージを含まないリプレイを返します。
+    const Replay& Game::replay()const
+    {
+        return mReplay ? *mReplay : ReplayStorage();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 一定ターンごとに保存したステージの状態を返します。
+    ///
+    /// @return 保存した状態を表す @c CheckpointStore クラスへの const 参照を返します。
+    ///         保存していない場合は、何も保存していない保存先を返します。
+    const CheckpointStore& Game::checkpoints()const
+    {
+        return mCheckpoints ? *mCheckpoints : CheckpointStorage();
+    }
 }
 
 //------------------------------------------------------------------------------
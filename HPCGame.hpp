@@ -10,10 +10,13 @@
 //------------------------------------------------------------------------------
 #pragma once
 
+#include "HPCCheckpoint.hpp"
 #include "HPCParameter.hpp"
 #include "HPCRandomSet.hpp"
 #include "HPCRecord.hpp"
+#include "HPCReplay.hpp"
 #include "HPCStage.hpp"
+#include "HPCStagePipeline.hpp"
 
 namespace hpc {
 
@@ -24,19 +27,28 @@ namespace hpc {
     public:
         Game(RandomSet& aRandSet);
 
+        void setRecordLevel(RecordLevel aLevel); ///< 記録レベルを設定します。
+        void setReplayEnabled(bool aIsEnabled); ///< リプレイを記録するかを設定します。
+        void setCheckpointInterval(int aInterval); ///< 状態を保存する間隔を設定します。
         void startStage();                  ///< 現在のステージを開始します。
         void runTurn();                     ///< 現在実行中のステージでターンを1つ進めます。
         StageState state()const;           ///< ステージ内での現在の状態を表します。
         void onStageDone();                 ///< ステージ終了を通知します。
         bool isValidStage()const;          ///< 現在のステージが有効なものかどうかを返します。
+        int stageIndex()const;             ///< 現在のステージ番号を返します。
 
         const Record& record()const;       ///< 記録へのアクセサ
+        const Replay& replay()const;       ///< リプレイへのアクセサ
+        const CheckpointStore& checkpoints()const; ///< 保存した状態へのアクセサ
 
     private:
         RandomSet& mRandSet;                ///< 乱数生成
         Stage mStage;                       ///< ステージ
         int mCurrentStageIndex;             ///< 現在のステージ番号
         Record mRecord;                     ///< 記録
+        Replay* mReplay;                    ///< リプレイ。記録しない場合は 0
+        CheckpointStore* mCheckpoints;      ///< 一定ターンごとに保存した状態。保存しない場合は 0
+        StagePipeline mStagePipeline;       ///< 次のステージを並行して生成する
     };
 }
 //------------------------------------------------------------------------------
@@ -0,0 +1,27 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    JsonFormat 列挙型
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief 記録を JSON で出力する際の形式を表します。
+    enum JsonFormat {
+        JsonFormat_Pretty,      ///< 空白・改行・インデントで整形された 1 つの JSON
+        JsonFormat_Compressed,  ///< 空白や改行を取り除いた 1 つの JSON
+        JsonFormat_Indexed,     ///< 圧縮した JSON に、ステージごとの位置を表す索引を付けたもの
+        JsonFormat_Lines,       ///< 基本情報の行と、ステージごとの行からなる JSON Lines
+
+        JsonFormat_TERM
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,177 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCJsonReader.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCJsonReader.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// 読み取る範囲を指定してインスタンスを生成します。
+    ///
+    /// @param[in] aBegin 範囲の先頭。
+    /// @param[in] aEnd   範囲の終端。
+    JsonReader::JsonReader(const char* aBegin, const char* aEnd)
+        : mCurrent(aBegin)
+        , mEnd(aEnd)
+        , mIsOk(aBegin <= aEnd)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 空白を読み飛ばした後、指定の文字を読み飛ばします。
+    ///
+    /// @param[in] aChar 読み飛ばす文字。
+    ///
+    /// @return 次の文字が aChar だった場合は @c true 。
+    bool JsonReader::expect(char aChar)
+    {
+        if (!isNext(aChar)) {
+            mIsOk = false;
+            return false;
+        }
+        ++mCurrent;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 空白を読み飛ばした後、次の文字が指定の文字かどうかを調べます。文字は読み飛ばしません。
+    ///
+    /// @param[in] aChar 調べる文字。
+    ///
+    /// @return 次の文字が aChar だった場合は @c true 。
+    bool JsonReader::isNext(char aChar)
+    {
+        skipSpace();
+        return mIsOk && mCurrent < mEnd && *mCurrent == aChar;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[out] aValue 読み取った整数。
+    ///
+    /// @return 読み取れた場合は @c true 。
+    bool JsonReader::readInt(int& aValue)
+    {
+        skipSpace();
+        const bool isNegative = mCurrent < mEnd && *mCurrent == '-';
+        if (isNegative) {
+            ++mCurrent;
+        }
+        int value = 0;
+        const char* const digitBegin = mCurrent;
+        while (mCurrent < mEnd && '0' <= *mCurrent && *mCurrent <= '9') {
+            value = value * 10 + (*mCurrent - '0');
+            ++mCurrent;
+        }
+        if (mCurrent == digitBegin) {
+            mIsOk = false;
+            return false;
+        }
+        aValue = isNegative ? -value : value;
+        return mIsOk;
+    }
+
+    //------------------------------------------------------------------------------
+    /// "%7.3f" などの書式で出力された実数を読み取ります。指数表記は扱いません。
+    ///
+    /// @param[out] aValue 読み取った実数。
+    ///
+    /// @return 読み取れた場合は @c true 。
+    bool JsonReader::readFloat(float& aValue)
+    {
+        skipSpace();
+        const bool isNegative = mCurrent < mEnd && *mCurrent == '-';
+        if (isNegative) {
+            ++mCurrent;
+        }
+        double integer = 0.0;
+        const char* const digitBegin = mCurrent;
+        while (mCurrent < mEnd && '0' <= *mCurrent && *mCurrent <= '9') {
+            integer = integer * 10.0 + (*mCurrent - '0');
+            ++mCurrent;
+        }
+        // 小数部は整数として読み、最後に 1 度だけ割ることで誤差を抑える。
+        double fraction = 0.0;
+        double scale = 1.0;
+        if (mCurrent < mEnd && *mCurrent == '.') {
+            ++mCurrent;
+            while (mCurrent < mEnd && '0' <= *mCurrent && *mCurrent <= '9') {
+                fraction = fraction * 10.0 + (*mCurrent - '0');
+                scale *= 10.0;
+                ++mCurrent;
+            }
+        }
+        if (mCurrent == digitBegin) {
+            mIsOk = false;
+            return false;
+        }
+        const double value = (integer * scale + fraction) / scale;
+        aValue = static_cast<float>(isNegative ? -value : value);
+        return mIsOk;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 空白を読み飛ばした後、配列を 1 つ読み飛ばします。
+    /// 記録の JSON には文字列が無いので、括弧の対応だけを数えます。
+    ///
+    /// @return 読み飛ばせた場合は @c true 。
+    bool JsonReader::skipArray()
+    {
+        if (!expect('[')) {
+            return false;
+        }
+        int depth = 1;
+        while (mCurrent < mEnd && depth > 0) {
+            if (*mCurrent == '[') {
+                ++depth;
+            } else if (*mCurrent == ']') {
+                --depth;
+            }
+            ++mCurrent;
+        }
+        if (depth > 0) {
+            mIsOk = false;
+        }
+        return mIsOk;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 次に読む位置。空白は読み飛ばしません。
+    const char* JsonReader::position()const
+    {
+        return mCurrent;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return これまでの読み取りがすべて成功している場合は @c true 。
+    bool JsonReader::isOk()const
+    {
+        return mIsOk;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 空白を除いて読み残しが無い場合は @c true 。
+    bool JsonReader::isEnd()
+    {
+        skipSpace();
+        return mCurrent == mEnd;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 空白と改行を読み飛ばします。
+    void JsonReader::skipSpace()
+    {
+        while (mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\n' || *mCurrent == '\r' || *mCurrent == '\t')) {
+            ++mCurrent;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,44 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    JsonReader クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief JsonWriter で出力した JSON を、先頭から順に読み取ります。
+    ///
+    /// 記録の JSON は数値と配列だけで構成されているので、それだけを扱います。
+    /// 読み取る範囲は終端文字を必要としないので、メモリにマップしたファイルの一部を直接読めます。
+    /// 読み取りに失敗すると、以降の読み取りはすべて失敗します。
+    class JsonReader
+    {
+    public:
+        JsonReader(const char* aBegin, const char* aEnd);
+
+        bool expect(char aChar);                            ///< 指定の文字を読み飛ばします。
+        bool isNext(char aChar);                            ///< 次の文字が指定の文字かどうかを返します。
+        bool readInt(int& aValue);                          ///< 整数を読み取ります。
+        bool readFloat(float& aValue);                      ///< 実数を読み取ります。
+        bool skipArray();                                   ///< 配列を 1 つ、中身を解釈せずに読み飛ばします。
+        const char* position()const;                       ///< 次に読む位置を返します。
+        bool isOk()const;                                  ///< これまでの読み取りが成功しているかどうかを返します。
+        bool isEnd();                                       ///< 空白を除いて終端に達しているかどうかを返します。
+
+    private:
+        const char* mCurrent;                               ///< 次に読む位置
+        const char* mEnd;                                   ///< 終端
+        bool mIsOk;                                         ///< 読み取りが成功しているか
+
+        void skipSpace();                                   ///< 空白と改行を読み飛ばします。
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCJsonWriter.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCJsonWriter.hpp"
+
+#include <cmath>
+#include <cstring>
+#include "HPCCommon.hpp"
+#include "HPCMath.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// 出力先を指定してインスタンスを生成します。
+    ///
+    /// @param[in] aFile 出力先。
+    JsonWriter::JsonWriter(std::FILE* aFile)
+        : mFile(aFile)
+        , mSize(0)
+        , mFlushed(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 溜めている文字列を書き出してから破棄します。
+    JsonWriter::~JsonWriter()
+    {
+        flush();
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aString 出力する文字列。
+    void JsonWriter::put(const char* aString)
+    {
+        const int length = static_cast<int>(std::strlen(aString));
+        if (length > BufferSize) {
+            flush();
+            std::fwrite(aString, 1, length, mFile);
+            mFlushed += length;
+            return;
+        }
+        reserve(length);
+        std::memcpy(mBuffer + mSize, aString, length);
+        mSize += length;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aChar 出力する文字。
+    void JsonWriter::put(char aChar)
+    {
+        reserve(1);
+        mBuffer[mSize++] = aChar;
+    }
+
+    //------------------------------------------------------------------------------
+    /// HPC_PRINT_JSON_DEBUG と同様に、整形用の空白や改行を出力するために使います。
+    ///
+    /// @param[in] aDoOutput 出力するかどうか。
+    /// @param[in] aString   出力する文字列。
+    void JsonWriter::putIf(bool aDoOutput, const char* aString)
+    {
+        if (aDoOutput) {
+            put(aString);
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aValue 出力する整数。
+    void JsonWriter::putInt(int aValue)
+    {
+        char digits[16];
+        int length = 0;
+        // INT_MIN でも溢れないよう、符号なしで桁を取り出す。
+        unsigned int value = aValue < 0 ? 0u - static_cast<unsigned int>(aValue) : static_cast<unsigned int>(aValue);
+        do {
+            digits[length++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        if (aValue < 0) {
+            digits[length++] = '-';
+        }
+        reserve(length);
+        while (length > 0) {
+            mBuffer[mSize++] = digits[--length];
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// "%7.3f" と同じ文字列を、書式の解釈なしで出力します。
+    ///
+    /// float の値を 1000 倍しても double では誤差が生じないため、
+    /// printf と同じく最近接偶数への丸めを行えば同じ桁が得られます。
+    ///
+    /// @param[in] aValue 出力する実数。
+    void JsonWriter::putFixed3(float aValue)
+    {
+        static const int Width = 7;
+        const double milli = Math::RoundHalfEven(std::fabs(static_cast<double>(aValue)) * 1000.0);
+        // 非数や大きすぎる値は printf に任せる。
+        if (!(milli < 1.0e15)) {
+            putFixed(aValue, Width, 3);
+            return;
+        }
+        char digits[32];
+        int length = 0;
+        unsigned long long value = static_cast<unsigned long long>(milli);
+        for (int index = 0; index < 3; ++index) {
+            digits[length++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        digits[length++] = '.';
+        do {
+            digits[length++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        // printf と同様に、 -0.0001 なども "-0.000" になる。
+        if (std::signbit(aValue)) {
+            digits[length++] = '-';
+        }
+        reserve(Width + length);
+        for (int pad = length; pad < Width; ++pad) {
+            mBuffer[mSize++] = ' ';
+        }
+        while (length > 0) {
+            mBuffer[mSize++] = digits[--length];
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// 任意の幅と精度で実数を出力します。 snprintf を使用します。
+    ///
+    /// @param[in] aValue     出力する実数。
+    /// @param[in] aWidth     最小の幅。
+    /// @param[in] aPrecision 小数点以下の桁数。
+    void JsonWriter::putFixed(float aValue, int aWidth, int aPrecision)
+    {
+        char text[64];
+        std::snprintf(text, sizeof(text), "%*.*f", aWidth, aPrecision, aValue);
+        put(text);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 溜めている文字列を 1 度の書き込みで出力先に書き出します。
+    void JsonWriter::flush()
+    {
+        if (mSize > 0) {
+            std::fwrite(mBuffer, 1, mSize, mFile);
+            mFlushed += mSize;
+            mSize = 0;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// バッファに溜めている分も含めた、これまでに出力した文字数を返します。
+    /// 出力先のファイルの先頭から書き始めていれば、次に書く文字の位置になります。
+    ///
+    /// @return 出力した文字数。
+    int JsonWriter::written()const
+    {
+        return mFlushed + mSize;
+    }
+
+    //------------------------------------------------------------------------------
+    /// バッファに aSize 文字を書き込めるよう、必要なら書き出します。
+    ///
+    /// @param[in] aSize 書き込む文字数。 BufferSize 以下である必要があります。
+    void JsonWriter::reserve(int aSize)
+    {
+        HPC_MAX_ASSERT_I(aSize, BufferSize);
+        if (mSize + aSize > BufferSize) {
+            flush();
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
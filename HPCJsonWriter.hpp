@@ -0,0 +1,49 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    JsonWriter クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdio>
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief JSON の出力をバッファに溜め、まとめて書き出します。
+    ///
+    /// 小さな printf を何度も呼ぶ代わりに使います。
+    /// 出力される文字列は、同じ書式を printf で出力した場合と同じになります。
+    class JsonWriter
+    {
+    public:
+        explicit JsonWriter(std::FILE* aFile);
+        ~JsonWriter();
+
+        void put(const char* aString);                      ///< 文字列を出力します。
+        void put(char aChar);                               ///< 1 文字を出力します。
+        void putIf(bool aDoOutput, const char* aString);    ///< 条件を満たす場合のみ文字列を出力します。
+        void putInt(int aValue);                            ///< "%d" と同じ書式で整数を出力します。
+        void putFixed3(float aValue);                       ///< "%7.3f" と同じ書式で実数を出力します。
+        void putFixed(float aValue, int aWidth, int aPrecision); ///< "%*.*f" と同じ書式で実数を出力します。
+        void flush();                                       ///< 溜めた文字列を書き出します。
+        int written()const;                                ///< これまでに出力した文字数を返します。
+
+    private:
+        static const int BufferSize = 1 << 16;              ///< バッファの大きさ
+
+        std::FILE* mFile;                                   ///< 出力先
+        int mSize;                                          ///< 溜めている文字数
+        int mFlushed;                                       ///< 書き出し済みの文字数
+        char mBuffer[BufferSize];                           ///< バッファ
+
+        void reserve(int aSize);                            ///< 指定文字数を書き込めるようにします。
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
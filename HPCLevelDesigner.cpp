@@ -17,6 +17,7 @@
 #include "HPCCommon.hpp"
 #include "HPCLevelGrid.hpp"
 #include "HPCMath.hpp"
+#include "HPCPerfCounter.hpp"
 #include "HPCRandom.hpp"
 
 namespace {
@@ -229,6 +230,8 @@ namespace hpc {
     /// @param[in,out]  aRandom 乱数
     void LevelDesigner::Setup(int aNumber, Stage& aStage, Random& aRandom)
     {
+        PerfScope perfScope(PerfRegion_LevelSetup);
+
         aStage.reset();
 
         HPC_RANGE_ASSERT_MIN_UB_I(aNumber, 0, Parameter::GameStageCount);
@@ -344,6 +347,56 @@ namespace hpc {
             }
         }
     }
+
+    //------------------------------------------------------------------------------
+    /// ステージの実行にかかる手間を、生成に使う値から見積もります。
+    ///
+    /// 乱数を使わずに決まる値だけを使うため、ステージを生成せずに求められます。
+    /// ターン数は、蓮の数と周回数とフィールドの大きさに比例するものとし、
+    /// 1 ターンの手間は、キャラの数とキャラ同士・キャラと蓮の衝突判定の数に比例するものとします。
+    ///
+    /// @param[in] aNumber ステージ番号
+    ///
+    /// @return 見積もった手間。単位はなく、ステージの間で比べるために使います。
+    double LevelDesigner::EstimateCost(int aNumber)
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aNumber, 0, Parameter::GameStageCount);
+        const int charaCount = BattleCharaCount(aNumber);
+        const int lotusCount = GetRandomLotusCount(aNumber);
+        const double turnCount = EstimateTurnCount(aNumber);
+        return turnCount * charaCount * (charaCount + lotusCount);
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージのターン数を、周回数・蓮の数・フィールドの大きさから見積もります。
+    ///
+    /// @param[in] aNumber ステージ番号
+    ///
+    /// @return 見積もったターン数。 Parameter::GameTurnPerStage を超えることはありません。
+    int LevelDesigner::EstimateTurnCount(int aNumber)
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aNumber, 0, Parameter::GameStageCount);
+        const IntVec2 gridSize = GetStageGridSize(aNumber);
+        const int lotusCount = GetRandomLotusCount(aNumber);
+        return Math::Min(Parameter::StageRoundCount * lotusCount * (gridSize.x + gridSize.y), Parameter::GameTurnPerStage);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 解答プログラムがステージを解くのにかかる手間を見積もります。
+    ///
+    /// EstimateCost にフィールドの流れを加味したものです。
+    /// 流れがあると探索する加速の幅が広がるため、実測で 1.6 倍程度の時間がかかります。
+    /// 流れの速さによる差は小さいため、流れの有無だけを見ます。
+    ///
+    /// @param[in] aNumber ステージ番号
+    ///
+    /// @return 手間の見積もり。ステージ間で比較するための相対的な値です。
+    double LevelDesigner::EstimateSolveCost(int aNumber)
+    {
+        static const double FlowCostRate = 1.6;
+        const bool hasFlow = GetFieldFlowVel(aNumber).squareLength() > 0.0f;
+        return EstimateCost(aNumber) * (hasFlow ? FlowCostRate : 1.0);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -22,6 +22,12 @@ namespace hpc {
     public:
         /// ステージのマップを生成します。
         static void Setup(int aNumber, Stage& aStage, Random& aRandom);
+        /// ステージの実行にかかる手間を見積もります。
+        static double EstimateCost(int aNumber);
+        /// ステージのターン数を見積もります。
+        static int EstimateTurnCount(int aNumber);
+        /// 解答プログラムがステージを解くのにかかる手間を見積もります。
+        static double EstimateSolveCost(int aNumber);
 
     private:
         LevelDesigner();
@@ -9,9 +9,12 @@
 
 //------------------------------------------------------------------------------
 
+#include <cstdlib>
 #include <cstring>
 #include "HPCCommon.hpp"
+#include "HPCPerfCounter.hpp"
 #include "HPCSimulation.hpp"
+#include "HPCTracer.hpp"
 
 //------------------------------------------------------------------------------
 namespace {
@@ -21,6 +24,15 @@ namespace {
         Operation_NoDebug,                  ///< デバッグなし
         Operation_OutputJson,               ///< JSON の出力
         Operation_OutputJsonCompressed,     ///< 圧縮された JSON の出力
+        Operation_OutputJsonLines,          ///< JSON Lines の出力
+        Operation_OutputSolverStats,        ///< 探索の統計情報の出力
+        Operation_OutputPerfCounter,        ///< ハードウェアカウンタの計測結果の出力
+        Operation_OutputTrace,              ///< タイムラインの出力
+        Operation_OutputReplay,             ///< リプレイの出力
+        Operation_OutputIndexedJson,        ///< 索引付きの JSON の出力
+        Operation_OutputBinary,             ///< ビューア用のバイナリの出力
+        Operation_DebugFile,                ///< 記録ファイルのデバッグ
+        Operation_DebugCheckpoint,          ///< 状態の保存間隔を指定したデバッグ
 
         Operation_TERM
     };
@@ -40,13 +52,23 @@ namespace {
 ///  ------------|----------------------------------------------
 ///   -n         | デバッグを行いません。
 ///   -j         | デバッグを行わず、結果を JSON で出力します。
+///   -jd        | デバッグを行わず、結果を整形された JSON で出力します。
+///   -jl        | デバッグを行わず、結果を基本情報とステージごとの行からなる JSON Lines で出力します。
+///   -s         | デバッグを行わず、探索の統計情報をステージごとに出力します。
+///   -p         | デバッグを行わず、区間ごとのハードウェアカウンタの値をステージごとに出力します。
+///   -t         | デバッグを行わず、処理区間のタイムラインを trace.json に出力します。
+///   -r         | デバッグを行わず、リプレイを replay.hpcr に出力し、再シミュレーションで検証します。
+///   -x         | デバッグを行わず、索引付きの JSON を record.json に出力し、ステージ単位の読み出しを検証します。
+///   -b         | デバッグを行わず、結果をビューア用のバイナリ形式で record.hpct に出力します。
+///   -l [file]  | ゲームを実行せず、 -x, -j, -jd で出力したファイル (既定は record.json) を読み込んでデバッグします。
+///   -k [turns] | ターン単位の移動に使う状態の保存間隔を指定して、デバッグを行います。既定は 64 ターンです。
 ///
 int main(int argc, const char* argv[])
 {
     Operation operation = Operation_Normal;
     
-    // 引数は 1 つまで有効。
-    if (argc > 2) {
+    // 引数は 1 つまで有効。ただし -l, -k は値を続けて指定できる。
+    if (argc > 3 || (argc == 3 && std::strcmp(argv[1], "-l") && std::strcmp(argv[1], "-k"))) {
         HPC_PRINT("Invalid Argument.\n");
         return 0;
     }
@@ -61,17 +83,109 @@ int main(int argc, const char* argv[])
         else if (!std::strcmp(argv[1], "-jd")) {
             operation = Operation_OutputJson;
         }
+        else if (!std::strcmp(argv[1], "-jl")) {
+            operation = Operation_OutputJsonLines;
+        }
+        else if (!std::strcmp(argv[1], "-s")) {
+            operation = Operation_OutputSolverStats;
+        }
+        else if (!std::strcmp(argv[1], "-p")) {
+            operation = Operation_OutputPerfCounter;
+            // 利用できない環境では計測せずに実行する。
+            hpc::PerfCounter::Enable();
+        }
+        else if (!std::strcmp(argv[1], "-r")) {
+            operation = Operation_OutputReplay;
+        }
+        else if (!std::strcmp(argv[1], "-x")) {
+            operation = Operation_OutputIndexedJson;
+        }
+        else if (!std::strcmp(argv[1], "-b")) {
+            operation = Operation_OutputBinary;
+        }
+        else if (!std::strcmp(argv[1], "-l")) {
+            operation = Operation_DebugFile;
+        }
+        else if (!std::strcmp(argv[1], "-k")) {
+            operation = Operation_DebugCheckpoint;
+            sSim.setCheckpointInterval(argc > 2 ? std::atoi(argv[2]) : hpc::CheckpointStore::DefaultInterval);
+        }
+        else if (!std::strcmp(argv[1], "-t")) {
+            operation = Operation_OutputTrace;
+            hpc::Tracer::Open("trace.json");
+        }
         else {
             HPC_PRINT("Invalid Argument: %s is unknown command.\n", argv[1]);
             return 0;
         }
     }
+    // 記録ファイルのデバッグではゲームを実行しない。
+    if (operation == Operation_DebugFile) {
+        sSim.debugFile(argc > 2 ? argv[2] : "record.json");
+        return 0;
+    }
     // プログラムの実行
     {
+        // 出力に必要な分だけ記録する。
+        switch (operation) {
+        case Operation_NoDebug:
+        case Operation_OutputPerfCounter:
+        case Operation_OutputTrace:
+        case Operation_OutputReplay:
+            sSim.setRecordLevel(hpc::RecordLevel_Score);
+            break;
+
+        case Operation_OutputSolverStats:
+            sSim.setRecordLevel(hpc::RecordLevel_Summary);
+            break;
+
+        default:
+            sSim.setRecordLevel(hpc::RecordLevel_Full);
+            break;
+        }
+        // リプレイは、出力する場合とデバッガでターン単位の移動を行う場合だけ記録する。
+        switch (operation) {
+        case Operation_Normal:
+        case Operation_DebugCheckpoint:
+        case Operation_OutputReplay:
+            sSim.setReplayEnabled(true);
+            break;
+
+        default:
+            break;
+        }
+        // ターン単位の移動に使う状態は、デバッガを使う場合だけ保存する。 -k では指定した間隔を設定済み。
+        if (operation == Operation_Normal) {
+            sSim.setCheckpointInterval(hpc::CheckpointStore::DefaultInterval);
+        }
+        // JSON はステージが終わるたびに並行して出力する。
+        switch (operation) {
+        case Operation_OutputJson:
+            sSim.startJsonStream(hpc::JsonFormat_Pretty);
+            break;
+
+        case Operation_OutputJsonCompressed:
+            sSim.startJsonStream(hpc::JsonFormat_Compressed);
+            break;
+
+        case Operation_OutputJsonLines:
+            sSim.startJsonStream(hpc::JsonFormat_Lines);
+            break;
+
+        case Operation_OutputIndexedJson:
+            if (!sSim.startIndexedJsonStream("record.json")) {
+                return 0;
+            }
+            break;
+
+        default:
+            break;
+        }
         sSim.run();
 
         switch (operation) {
         case Operation_Normal:
+        case Operation_DebugCheckpoint:
             sSim.outputResult();
             sSim.debug();
             break;
@@ -88,6 +202,40 @@ int main(int argc, const char* argv[])
             sSim.outputJson(true);
             break;
 
+        case Operation_OutputJsonLines:
+            sSim.outputJsonLines();
+            break;
+
+        case Operation_OutputSolverStats:
+            sSim.outputSolverStats();
+            sSim.outputResult();
+            break;
+
+        case Operation_OutputPerfCounter:
+            hpc::PerfCounter::Dump();
+            sSim.outputResult();
+            break;
+
+        case Operation_OutputTrace:
+            hpc::Tracer::Close();
+            sSim.outputResult();
+            break;
+
+        case Operation_OutputReplay:
+            sSim.outputResult();
+            sSim.outputReplay("replay.hpcr");
+            break;
+
+        case Operation_OutputIndexedJson:
+            sSim.outputResult();
+            sSim.outputIndexedJson("record.json");
+            break;
+
+        case Operation_OutputBinary:
+            sSim.outputResult();
+            sSim.outputBinary("record.hpct");
+            break;
+
         default:
             HPC_SHOULD_NOT_REACH_HERE();
             break;
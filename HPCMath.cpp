@@ -141,6 +141,23 @@ namespace hpc {
         return static_cast<int>(std::ceil(aValue));
     }
 
+    //------------------------------------------------------------------------------
+    /// printf で小数点以下を丸める場合と同じく、最も近い整数に丸めます。
+    /// ちょうど中間の値の場合は偶数側に丸めます。
+    ///
+    /// @return aValue を丸めた値を返します。
+    double Math::RoundHalfEven(double aValue)
+    {
+        const double floor = std::floor(aValue);
+        const double diff = aValue - floor;
+        if (diff < 0.5) {
+            return floor;
+        } else if (0.5 < diff) {
+            return floor + 1.0;
+        }
+        return std::fmod(floor, 2.0) == 0.0 ? floor : floor + 1.0;
+    }
+
     //------------------------------------------------------------------------------
     /// @param[in] aValue 判定する値。
     ///
@@ -36,6 +36,7 @@ namespace hpc {
         static float LimitAbs(float aValue, float aLimitAbs);           ///< 値を指定の大きさに制限します。
         static float Sqrt(float aValue);                                ///< 値の平方根を求めます。
         static int Ceil(float aValue);                                  ///< 小数点の値を切り上げます。
+        static double RoundHalfEven(double aValue);                     ///< 最も近い整数に丸めます。中間の値は偶数側に丸めます。
         static bool IsValid(float aValue);                              ///< 浮動小数点の値が有効値かどうかを判定します。
         //@}
 
@@ -0,0 +1,262 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCPerfCounter.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCPerfCounter.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include "HPCCommon.hpp"
+#include "HPCParameter.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    using namespace hpc;
+
+    /// 区間ごとの計測結果
+    struct RegionStat
+    {
+        unsigned long long calls;                           ///< 計測した回数
+        unsigned long long values[PerfEvent_TERM];          ///< イベントごとの合計値
+    };
+
+    /// 計測結果の表示名
+    const char* const RegionNames[PerfRegion_TERM] = {
+        "Search"
+        , "CheckColl"
+        , "LevelSetup"
+        };
+
+    bool sIsEnabled = false;                                ///< 計測が有効か
+    int sStageIndex = 0;                                    ///< 集計先のステージ番号
+    int sFds[PerfEvent_TERM];                               ///< イベントごとのファイルディスクリプタ。開けなければ -1
+    int sSlots[PerfEvent_TERM];                             ///< グループ読み出し時のイベントの位置。開けなければ -1
+    int sOpenCount = 0;                                     ///< 開けたイベントの数
+    unsigned long long sBegin[PerfRegion_TERM][PerfEvent_TERM]; ///< 区間開始時の値
+    RegionStat sStats[Parameter::GameStageCount][PerfRegion_TERM]; ///< ステージ・区間ごとの計測結果
+
+#ifdef __linux__
+    //------------------------------------------------------------------------------
+    /// イベントのカウンタを開きます。
+    ///
+    /// @param[in] aEvent   開くイベント。
+    /// @param[in] aGroupFd グループリーダーのファイルディスクリプタ。自身がリーダーなら -1。
+    ///
+    /// @return ファイルディスクリプタ。開けなかった場合は -1。
+    int OpenEvent(PerfEvent aEvent, int aGroupFd)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        switch (aEvent) {
+        case PerfEvent_Cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfEvent_Instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfEvent_L1DMiss:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PerfEvent_LLCMiss:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PerfEvent_BranchMiss:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            HPC_SHOULD_NOT_REACH_HERE();
+            return -1;
+        }
+        attr.disabled = aGroupFd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, aGroupFd, 0));
+    }
+
+    //------------------------------------------------------------------------------
+    /// グループの全カウンタを 1 回のシステムコールで読み出します。
+    ///
+    /// @param[out] aValues イベントごとの値。開けなかったイベントは 0 になります。
+    void ReadEvents(unsigned long long* aValues)
+    {
+        unsigned long long buffer[PerfEvent_TERM + 1];
+        const ssize_t size = read(sFds[PerfEvent_Cycles], buffer, sizeof(buffer));
+        const bool isValid = size >= static_cast<ssize_t>(sizeof(unsigned long long) * (sOpenCount + 1));
+        for (int event = 0; event < PerfEvent_TERM; ++event) {
+            aValues[event] = (isValid && sSlots[event] >= 0) ? buffer[1 + sSlots[event]] : 0;
+        }
+    }
+#endif
+}
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// カウンタを開き、計測を有効にします。
+    ///
+    /// サイクル数のカウンタが開けない場合は計測を無効のままにします。
+    /// その他のイベントは、開けないものだけを計測から除きます。
+    ///
+    /// @return 計測が有効になった場合は @c true 。
+    bool PerfCounter::Enable()
+    {
+        if (sIsEnabled) {
+            return true;
+        }
+        for (int event = 0; event < PerfEvent_TERM; ++event) {
+            sFds[event] = -1;
+            sSlots[event] = -1;
+        }
+        sOpenCount = 0;
+#ifdef __linux__
+        sFds[PerfEvent_Cycles] = OpenEvent(PerfEvent_Cycles, -1);
+        if (sFds[PerfEvent_Cycles] < 0) {
+            HPC_PRINT("PerfCounter: hardware counters are unavailable. (%s)\n", std::strerror(errno));
+            return false;
+        }
+        sSlots[PerfEvent_Cycles] = sOpenCount++;
+        for (int event = PerfEvent_Cycles + 1; event < PerfEvent_TERM; ++event) {
+            sFds[event] = OpenEvent(static_cast<PerfEvent>(event), sFds[PerfEvent_Cycles]);
+            if (sFds[event] >= 0) {
+                sSlots[event] = sOpenCount++;
+            }
+        }
+        ioctl(sFds[PerfEvent_Cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(sFds[PerfEvent_Cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        std::memset(sStats, 0, sizeof(sStats));
+        sIsEnabled = true;
+        return true;
+#else
+        HPC_PRINT("PerfCounter: hardware counters are supported only on Linux.\n");
+        return false;
+#endif
+    }
+
+    //------------------------------------------------------------------------------
+    bool PerfCounter::IsEnabled()
+    {
+        return sIsEnabled;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 以降の計測結果を集計するステージを設定します。
+    ///
+    /// @param[in] aStageIndex ステージ番号。
+    void PerfCounter::SetStage(int aStageIndex)
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        sStageIndex = aStageIndex;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 区間の計測を開始します。計測が無効の場合は何もしません。
+    ///
+    /// @param[in] aRegion 計測する区間。
+    void PerfCounter::Begin(PerfRegion aRegion)
+    {
+        if (!sIsEnabled) {
+            return;
+        }
+#ifdef __linux__
+        ReadEvents(sBegin[aRegion]);
+#endif
+    }
+
+    //------------------------------------------------------------------------------
+    /// 区間の計測を終了し、開始時からの差分を現在のステージに加算します。
+    /// 計測が無効の場合は何もしません。
+    ///
+    /// @param[in] aRegion 計測している区間。
+    void PerfCounter::End(PerfRegion aRegion)
+    {
+        if (!sIsEnabled) {
+            return;
+        }
+#ifdef __linux__
+        unsigned long long values[PerfEvent_TERM];
+        ReadEvents(values);
+        RegionStat& stat = sStats[sStageIndex][aRegion];
+        ++stat.calls;
+        for (int event = 0; event < PerfEvent_TERM; ++event) {
+            stat.values[event] += values[event] - sBegin[aRegion][event];
+        }
+#endif
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージ・区間ごとの計測結果と、区間ごとの合計を画面に出力します。
+    /// 計測できなかったイベントは - で表示します。
+    void PerfCounter::Dump()
+    {
+        if (!sIsEnabled) {
+            return;
+        }
+        HPC_PRINT(
+            "%5s %-10s %9s %14s %14s %5s %12s %12s %12s\n"
+            , "Stage", "Region", "Calls", "Cycles", "Instructions", "IPC", "L1DMiss", "LLCMiss", "BranchMiss"
+            );
+        RegionStat total[PerfRegion_TERM];
+        std::memset(total, 0, sizeof(total));
+        for (int stage = 0; stage <= Parameter::GameStageCount; ++stage) {
+            for (int region = 0; region < PerfRegion_TERM; ++region) {
+                const bool isTotal = stage == Parameter::GameStageCount;
+                const RegionStat& stat = isTotal ? total[region] : sStats[stage][region];
+                if (!isTotal) {
+                    total[region].calls += stat.calls;
+                    for (int event = 0; event < PerfEvent_TERM; ++event) {
+                        total[region].values[event] += stat.values[event];
+                    }
+                }
+                if (stat.calls == 0) {
+                    continue;
+                }
+                if (isTotal) {
+                    HPC_PRINT("%5s ", "Total");
+                } else {
+                    HPC_PRINT("%5d ", stage);
+                }
+                HPC_PRINT("%-10s %9llu", RegionNames[region], stat.calls);
+                for (int event = 0; event < PerfEvent_TERM; ++event) {
+                    const int width = event <= PerfEvent_Instructions ? 14 : 12;
+                    if (sSlots[event] < 0) {
+                        HPC_PRINT(" %*s", width, "-");
+                    } else {
+                        HPC_PRINT(" %*llu", width, stat.values[event]);
+                    }
+                    if (event == PerfEvent_Instructions) {
+                        if (sSlots[PerfEvent_Instructions] < 0 || stat.values[PerfEvent_Cycles] == 0) {
+                            HPC_PRINT(" %5s", "-");
+                        } else {
+                            HPC_PRINT(" %5.2f", static_cast<double>(stat.values[PerfEvent_Instructions]) / stat.values[PerfEvent_Cycles]);
+                        }
+                    }
+                }
+                HPC_PRINT("\n");
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
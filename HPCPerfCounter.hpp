@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    PerfCounter クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+namespace hpc {
+
+    /// ハードウェアカウンタで計測する区間
+    enum PerfRegion {
+        PerfRegion_Search,              ///< 解答プログラムの探索
+        PerfRegion_CheckColl,           ///< キャラの衝突判定 (CharaCollection::procCheckColl)
+        PerfRegion_LevelSetup,          ///< ステージの生成 (LevelDesigner::Setup)
+
+        PerfRegion_TERM
+    };
+
+    /// 計測するハードウェアイベント
+    enum PerfEvent {
+        PerfEvent_Cycles,               ///< CPU サイクル数
+        PerfEvent_Instructions,         ///< 実行した命令数
+        PerfEvent_L1DMiss,              ///< L1 データキャッシュのミス
+        PerfEvent_LLCMiss,              ///< 最終レベルキャッシュのミス
+        PerfEvent_BranchMiss,           ///< 分岐予測ミス
+
+        PerfEvent_TERM
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief ハードウェアパフォーマンスカウンタで区間ごとの計測を行います。
+    ///
+    /// Linux の perf_event_open を利用します。
+    /// Enable() を呼ばない限り、またはカウンタが利用できない環境では何も計測しません。
+    class PerfCounter
+    {
+    public:
+        static bool Enable();                               ///< 計測を有効にします。
+        static bool IsEnabled();                            ///< 計測が有効かどうかを返します。
+        static void SetStage(int aStageIndex);              ///< 計測結果を集計するステージを設定します。
+        static void Begin(PerfRegion aRegion);              ///< 区間の計測を開始します。
+        static void End(PerfRegion aRegion);                ///< 区間の計測を終了します。
+        static void Dump();                                 ///< 計測結果を画面に表示します。
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief スコープの間 PerfCounter で区間を計測します。
+    class PerfScope
+    {
+    public:
+        explicit PerfScope(PerfRegion aRegion)
+            : mRegion(aRegion)
+        {
+            PerfCounter::Begin(mRegion);
+        }
+        ~PerfScope()
+        {
+            PerfCounter::End(mRegion);
+        }
+
+    private:
+        const PerfRegion mRegion;                           ///< 計測している区間
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
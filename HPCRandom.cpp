@@ -62,6 +62,20 @@ namespace hpc {
         return aMin + randTerm(1 + aMax - aMin);
     }
 
+    //------------------------------------------------------------------------------
+    /// @return 現在の乱数列の状態。同じシードでインスタンスを生成すると、以降同じ乱数列が得られます。
+    uint Random::seedX()const
+    {
+        return mSeedX;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 現在の乱数列の状態。同じシードでインスタンスを生成すると、以降同じ乱数列が得られます。
+    uint Random::seedY()const
+    {
+        return mSeedY;
+    }
+
     //------------------------------------------------------------------------------
     /// [0, UINT_MAX] の範囲をもつ乱数を内部で計算して乱数列を1つ進め、
     /// 現在の値を返します。
@@ -27,6 +27,9 @@ namespace hpc {
         int randMinTerm(int aMin, int aTerm);   ///< [aMin, aTerm) の範囲で乱数を取得します。
         int randMinMax(int aMin, int aMax);     ///< [aMin, aMax] の範囲で乱数を取得します。
 
+        uint seedX()const;                     ///< 現在のシードを取得します。
+        uint seedY()const;                     ///< 現在のシードを取得します。
+
     private:
         uint mSeedX;            ///< 乱数のシード
         uint mSeedY;            ///< 乱数のシード
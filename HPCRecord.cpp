@@ -11,7 +11,17 @@
 
 #include "HPCRecord.hpp"
 
+#include <cstdio>
 #include "HPCCommon.hpp"
+#include "HPCJsonWriter.hpp"
+
+namespace {
+
+    /// バイナリ形式のファイルの先頭に置く識別子
+    const char BinaryMagic[4] = { 'H', 'P', 'C', 'T' };
+    /// バイナリ形式のバージョン
+    const uint BinaryVersion = 1;
+}
 
 namespace hpc {
 
@@ -23,6 +33,17 @@ namespace hpc {
     {
     }
 
+    //------------------------------------------------------------------------------
+    /// 全ステージの記録レベルを設定します。記録を開始する前に呼び出します。
+    ///
+    /// @param[in] aLevel 記録レベル。
+    void Record::setLevel(RecordLevel aLevel)
+    {
+        for (int index = 0; index < Parameter::GameStageCount; ++index) {
+            mStage[index].setLevel(aLevel);
+        }
+    }
+
     //------------------------------------------------------------------------------
     /// ステージ開始時に一度呼ぶことで、ステージ開始を記録します。
     ///
@@ -102,7 +123,8 @@ namespace hpc {
     void Record::dumpJsonStage(int aStageIndex)const
     {
         HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
-        mStage[aStageIndex].dumpJson(false);
+        JsonWriter writer(stdout);
+        mStage[aStageIndex].dumpJson(writer, false);
     }
 
     //------------------------------------------------------------------------------
@@ -114,47 +136,221 @@ namespace hpc {
     ///                         形で出力されます。
     void Record::dumpJson(bool isCompressed)const
     {
-        HPC_PRINT("[");
-        HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+        JsonWriter writer(stdout);
+        writeJsonHeader(writer, isCompressed);
+        for (int index = 0; index < Parameter::GameStageCount; ++index) {
+            writeJsonStage(writer, index, isCompressed, 0);
+        }
+        writeJsonFooter(writer, isCompressed, 0);
+    }
+
+    //------------------------------------------------------------------------------
+    /// ゲームの全情報を JSON Lines 形式で出力します。
+    ///
+    /// 1 行目は基本情報、続く各行は 1 ステージ分の情報で、それぞれ dumpJson の
+    /// トップレベルの配列の要素を圧縮した形と同じです。
+    /// ビューアはステージの行を読むたびに、そのステージを表示できます。
+    void Record::dumpJsonLines()const
+    {
+        JsonWriter writer(stdout);
+        writeJsonLinesHeader(writer);
+        for (int index = 0; index < Parameter::GameStageCount; ++index) {
+            writeJsonLine(writer, index);
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// ゲームの全情報を、ビューアが JSON を解析せずに読めるバイナリ形式で保存します。
+    ///
+    /// 先頭は識別子 "HPCT" (4 バイト)、バージョン、キャラの半径 (float32)、
+    /// 周回数、ステージ数 (各 4 バイト) で、続けて各ステージを RecordStage::writeBinary の形式で並べます。
+    ///
+    /// @param[in] aFileName ファイル名。
+    ///
+    /// @return 保存に成功した場合は @c true 。
+    bool Record::saveBinary(const char* aFileName)const
+    {
+        std::FILE* file = std::fopen(aFileName, "wb");
+        if (!file) {
+            return false;
+        }
+        const float radius = Parameter::CharaRadius();
+        const int counts[] = { Parameter::StageRoundCount, Parameter::GameStageCount };
+        bool isSucceeded = std::fwrite(BinaryMagic, sizeof(BinaryMagic), 1, file) == 1
+            && std::fwrite(&BinaryVersion, sizeof(BinaryVersion), 1, file) == 1
+            && std::fwrite(&radius, sizeof(radius), 1, file) == 1
+            && std::fwrite(counts, sizeof(counts), 1, file) == 1;
+        for (int index = 0; isSucceeded && index < Parameter::GameStageCount; ++index) {
+            isSucceeded = mStage[index].writeBinary(file);
+        }
+        return std::fclose(file) == 0 && isSucceeded;
+    }
+
+    //------------------------------------------------------------------------------
+    /// dumpJson で出力する JSON のうち、ステージ情報より前の部分を出力します。
+    ///
+    /// @param[in] aWriter      出力先。
+    /// @param[in] isCompressed 圧縮した形で出力するかどうか。
+    void Record::writeJsonHeader(JsonWriter& aWriter, bool isCompressed)
+    {
+        aWriter.put("[");
+        aWriter.putIf(!isCompressed, "\n");
 
             // 基本情報
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "    "); // インデント (4)
-            HPC_PRINT("[");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            aWriter.putIf(!isCompressed, "    "); // インデント (4)
+            aWriter.put("[");
+            aWriter.putIf(!isCompressed, "\n");
 
                 // 忍者半径
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "        "); // インデント (8)
-                HPC_PRINT("%7.3f,", Parameter::CharaRadius());
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "        "); // インデント (8)
+                aWriter.putFixed3(Parameter::CharaRadius());
+                aWriter.put(',');
+                aWriter.putIf(!isCompressed, "\n");
 
                 // 必要周回数
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "        "); // インデント (8)
-                HPC_PRINT("%d", Parameter::StageRoundCount);
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "        "); // インデント (8)
+                aWriter.putInt(Parameter::StageRoundCount);
+                aWriter.putIf(!isCompressed, "\n");
 
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "    "); // インデント (4)
-            HPC_PRINT("],");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            aWriter.putIf(!isCompressed, "    "); // インデント (4)
+            aWriter.put("],");
+            aWriter.putIf(!isCompressed, "\n");
 
             // ステージ情報表示
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "    "); // インデント (4)
-            HPC_PRINT("[");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-
-            for (int index = 0; index < Parameter::GameStageCount; ++index) {
-                mStage[index].dumpJson(isCompressed);
-                if (index + 1 < Parameter::GameStageCount) {
-                    HPC_PRINT(",");
-                }
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            aWriter.putIf(!isCompressed, "    "); // インデント (4)
+            aWriter.put("[");
+            aWriter.putIf(!isCompressed, "\n");
+    }
+
+    //------------------------------------------------------------------------------
+    /// dumpJson で出力する JSON のうち、1 ステージ分を区切り文字も含めて出力します。
+    ///
+    /// 記録が終わったステージであれば、後のステージを記録している間に呼び出すことが出来ます。
+    ///
+    /// @param[in] aWriter      出力先。
+    /// @param[in] aStageIndex  ステージ番号。
+    /// @param[in] isCompressed 圧縮した形で出力するかどうか。
+    /// @param[in] aIndex       ステージの位置を追加する索引。不要な場合は 0 。
+    void Record::writeJsonStage(JsonWriter& aWriter, int aStageIndex, bool isCompressed, RecordIndex* aIndex)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        const RecordStage& stage = mStage[aStageIndex];
+        const int offset = aWriter.written();
+        stage.dumpJson(aWriter, isCompressed);
+        if (aIndex) {
+            aIndex->add(
+                offset
+                , aWriter.written() - offset
+                , static_cast<int>(stage.score())
+                , stage.recordedTurnCount()
+                , stage.endState()
+                );
+        }
+        if (aStageIndex + 1 < Parameter::GameStageCount) {
+            aWriter.put(",");
+        }
+        aWriter.putIf(!isCompressed, "\n");
+    }
+
+    //------------------------------------------------------------------------------
+    /// dumpJson で出力する JSON のうち、ステージ情報より後の部分を出力します。
+    ///
+    /// @param[in] aWriter      出力先。
+    /// @param[in] isCompressed 圧縮した形で出力するかどうか。
+    /// @param[in] aIndex       ステージ情報の後に出力する索引。不要な場合は 0 。
+    void Record::writeJsonFooter(JsonWriter& aWriter, bool isCompressed, const RecordIndex* aIndex)
+    {
+            aWriter.putIf(!isCompressed, "    "); // インデント (4)
+            aWriter.put("]");
+            if (aIndex) {
+                aIndex->write(aWriter);
             }
+            aWriter.putIf(!isCompressed, "\n");
 
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "    "); // インデント (4)
-            HPC_PRINT("]");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+        aWriter.putIf(!isCompressed, "\n");
+        aWriter.put("]\n");
+    }
 
-        HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-        HPC_PRINT("]\n");
+    //------------------------------------------------------------------------------
+    /// dumpJsonLines で出力する、基本情報の行を出力します。
+    ///
+    /// @param[in] aWriter 出力先。
+    void Record::writeJsonLinesHeader(JsonWriter& aWriter)
+    {
+        aWriter.put('[');
+        aWriter.putFixed3(Parameter::CharaRadius());
+        aWriter.put(',');
+        aWriter.putInt(Parameter::StageRoundCount);
+        aWriter.put("]\n");
+    }
+
+    //------------------------------------------------------------------------------
+    /// dumpJsonLines で出力する、 1 ステージ分の行を出力します。
+    ///
+    /// 記録が終わったステージであれば、後のステージを記録している間に呼び出すことが出来ます。
+    ///
+    /// @param[in] aWriter     出力先。
+    /// @param[in] aStageIndex ステージ番号。
+    void Record::writeJsonLine(JsonWriter& aWriter, int aStageIndex)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        mStage[aStageIndex].dumpJson(aWriter, true);
+        aWriter.put('\n');
+    }
+
+    //------------------------------------------------------------------------------
+    /// 解答プログラムの探索に関する統計情報を、ステージごとの一覧として画面に出力します。
+    /// 最後に全ステージの合計を出力します。
+    void Record::dumpSolverStats()const
+    {
+        HPC_PRINT(
+            "%5s %7s %6s %5s %5s %5s %5s %6s %11s %5s %7s %8s %8s %6s %8s %8s\n"
+            , "Stage", "Score", "Replan", "Init", "Thr", "Dev", "Seg", "SegHit", "Expanded"
+            , "MaxD", "AvgD", "Time", "MaxTime", "DevCnt", "DevAvg", "DevMax"
+            );
+        SolverStats total;
+        for (int index = 0; index < Parameter::GameStageCount; ++index) {
+            const SolverStats& stats = mStage[index].solverStats();
+            total.add(stats);
+            HPC_PRINT(
+                "%5d %7d %6d %5d %5d %5d %5d %6d %11lld %5d %7.1f %8.4f %8.4f %6d %8.4f %8.4f\n"
+                , index
+                , static_cast<int>(mStage[index].score())
+                , stats.replanCount()
+                , stats.replanCount(ReplanReason_Initial)
+                , stats.replanCount(ReplanReason_Threshold)
+                , stats.replanCount(ReplanReason_Deviation)
+                , stats.replanCount(ReplanReason_Segment)
+                , stats.segmentHitCount()
+                , stats.expandedCells()
+                , stats.maxDepth()
+                , stats.averageDepth()
+                , stats.searchSec()
+                , stats.maxSearchSec()
+                , stats.deviationCount()
+                , stats.averageDeviation()
+                , stats.maxDeviation()
+                );
+        }
+        HPC_PRINT(
+            "%5s %7d %6d %5d %5d %5d %5d %6d %11lld %5d %7.1f %8.4f %8.4f %6d %8.4f %8.4f\n"
+            , "Total"
+            , score()
+            , total.replanCount()
+            , total.replanCount(ReplanReason_Initial)
+            , total.replanCount(ReplanReason_Threshold)
+            , total.replanCount(ReplanReason_Deviation)
+            , total.replanCount(ReplanReason_Segment)
+            , total.segmentHitCount()
+            , total.expandedCells()
+            , total.maxDepth()
+            , total.averageDepth()
+            , total.searchSec()
+            , total.maxSearchSec()
+            , total.deviationCount()
+            , total.averageDeviation()
+            , total.maxDeviation()
+            );
     }
 }
 
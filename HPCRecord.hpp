@@ -10,6 +10,7 @@
 //------------------------------------------------------------------------------
 #pragma once
 
+#include "HPCRecordFile.hpp"
 #include "HPCRecordStage.hpp"
 #include "HPCStage.hpp"
 #include "HPCTurnResult.hpp"
@@ -23,6 +24,8 @@ namespace hpc {
     public:
         Record();
 
+        void setLevel(RecordLevel aLevel);                          ///< 記録レベルを設定します。
+
         /// @name 記録動作を行う関数
         //@{
         void writeStartStage(int aStageIndex, const Stage& aStage); ///< ステージの記録を開始します。
@@ -36,6 +39,18 @@ namespace hpc {
         void dumpStage(int aStageIndex)const;              ///< ステージの結果を出力します。
         void dumpJsonStage(int aStageIndex)const;          ///< ステージの結果を JSON で出力します。
         void dumpJson(bool isCompressed)const;             ///< 全結果を JSON で出力します。
+        void dumpJsonLines()const;                         ///< 全結果を JSON Lines で出力します。
+        void dumpSolverStats()const;                       ///< 探索の統計情報を一覧で出力します。
+        bool saveBinary(const char* aFileName)const;       ///< 全結果をビューア用のバイナリ形式で保存します。
+        //@}
+
+        /// @name JSON を部分ごとに出力する関数
+        //@{
+        static void writeJsonHeader(JsonWriter& aWriter, bool isCompressed); ///< ステージ情報より前の部分を出力します。
+        void writeJsonStage(JsonWriter& aWriter, int aStageIndex, bool isCompressed, RecordIndex* aIndex)const; ///< 1 ステージ分を出力します。
+        static void writeJsonFooter(JsonWriter& aWriter, bool isCompressed, const RecordIndex* aIndex); ///< ステージ情報より後の部分を出力します。
+        static void writeJsonLinesHeader(JsonWriter& aWriter);             ///< JSON Lines の基本情報の行を出力します。
+        void writeJsonLine(JsonWriter& aWriter, int aStageIndex)const;     ///< JSON Lines のステージの行を出力します。
         //@}
 
     private:
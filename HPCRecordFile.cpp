@@ -0,0 +1,384 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCRecordFile.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCRecordFile.hpp"
+
+#include "HPCCommon.hpp"
+#include "HPCJsonReader.hpp"
+#include "HPCJsonWriter.hpp"
+#include "HPCRecordStage.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    RecordIndex::RecordIndex()
+        : mEntries()
+        , mCount(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 索引を空にします。
+    void RecordIndex::reset()
+    {
+        mCount = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージの索引を追加します。ステージ番号の順に追加する必要があります。
+    ///
+    /// @param[in] aOffset    ステージの JSON の位置。
+    /// @param[in] aLength    ステージの JSON の長さ。
+    /// @param[in] aScore     得点。
+    /// @param[in] aTurnCount 記録しているターン数。
+    /// @param[in] aEndState  終了時の状態。
+    void RecordIndex::add(int aOffset, int aLength, int aScore, int aTurnCount, StageState aEndState)
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(mCount, 0, Parameter::GameStageCount);
+        Entry& entry = mEntries[mCount++];
+        entry.offset = aOffset;
+        entry.length = aLength;
+        entry.score = aScore;
+        entry.turnCount = aTurnCount;
+        entry.endState = aEndState;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 索引の数。
+    int RecordIndex::count()const
+    {
+        return mCount;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aStageIndex ステージ番号。
+    ///
+    /// @return 指定したステージの索引。
+    const RecordIndex::Entry& RecordIndex::entry(int aStageIndex)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, mCount);
+        return mEntries[aStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    /// 索引と、その位置を出力します。
+    /// ステージ情報の配列を閉じた直後に呼び出します。トップレベルの配列を閉じるのは呼び出し元です。
+    ///
+    /// @param[in] aWriter 出力先。ファイルの先頭から出力している必要があります。
+    void RecordIndex::write(JsonWriter& aWriter)const
+    {
+        aWriter.put(',');
+        const int indexOffset = aWriter.written();
+        aWriter.put('[');
+        for (int index = 0; index < mCount; ++index) {
+            const Entry& entry = mEntries[index];
+            if (index > 0) {
+                aWriter.put(',');
+            }
+            aWriter.put('[');
+            aWriter.putInt(entry.offset);
+            aWriter.put(',');
+            aWriter.putInt(entry.length);
+            aWriter.put(',');
+            aWriter.putInt(entry.score);
+            aWriter.put(',');
+            aWriter.putInt(entry.turnCount);
+            aWriter.put(',');
+            aWriter.putInt(entry.endState);
+            aWriter.put(']');
+        }
+        aWriter.put("],");
+        aWriter.putInt(indexOffset);
+    }
+
+    //------------------------------------------------------------------------------
+    /// write で出力した索引の配列を読み取ります。
+    ///
+    /// @param[in] aReader 索引の配列の先頭を指す読み取りクラス。
+    ///
+    /// @return 読み取れた場合は @c true 。
+    bool RecordIndex::read(JsonReader& aReader)
+    {
+        reset();
+        aReader.expect('[');
+        while (aReader.isOk() && !aReader.isNext(']')) {
+            if (mCount > 0) {
+                aReader.expect(',');
+            }
+            if (mCount >= Parameter::GameStageCount) {
+                return false;
+            }
+            Entry& entry = mEntries[mCount];
+            int endState = 0;
+            aReader.expect('[');
+            aReader.readInt(entry.offset);
+            aReader.expect(',');
+            aReader.readInt(entry.length);
+            aReader.expect(',');
+            aReader.readInt(entry.score);
+            aReader.expect(',');
+            aReader.readInt(entry.turnCount);
+            aReader.expect(',');
+            aReader.readInt(endState);
+            aReader.expect(']');
+            if (endState < 0 || StageState_TERM <= endState) {
+                return false;
+            }
+            entry.endState = static_cast<StageState>(endState);
+            ++mCount;
+        }
+        aReader.expect(']');
+        return aReader.isOk();
+    }
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    RecordFile::RecordFile()
+        : mData(0)
+        , mSize(0)
+        , mIndex()
+        , mHasIndex(false)
+#ifdef _WIN32
+        , mFileHandle(INVALID_HANDLE_VALUE)
+        , mMappingHandle(0)
+#endif
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// ファイルを開いている場合は閉じてから破棄します。
+    RecordFile::~RecordFile()
+    {
+        close();
+    }
+
+    //------------------------------------------------------------------------------
+    /// ファイルをメモリにマップし、索引を読み取ります。
+    /// 索引が無い場合は、ステージ情報を走査して位置だけの索引を作ります。
+    /// 開いているファイルがある場合は、先に閉じます。
+    ///
+    /// @param[in] aFileName ファイル名。
+    ///
+    /// @return 索引を読み取れたか、ステージの位置を求められた場合は @c true 。
+    bool RecordFile::open(const char* aFileName)
+    {
+        close();
+#ifdef _WIN32
+        mFileHandle = CreateFileA(aFileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if (mFileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        mSize = static_cast<int>(GetFileSize(mFileHandle, 0));
+        if (mSize > 0) {
+            mMappingHandle = CreateFileMappingA(mFileHandle, 0, PAGE_READONLY, 0, 0, 0);
+            if (mMappingHandle != 0) {
+                mData = static_cast<const char*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+            }
+        }
+#else
+        const int fd = ::open(aFileName, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            mSize = static_cast<int>(fileStat.st_size);
+            void* const data = mmap(0, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                mData = static_cast<const char*>(data);
+            }
+        }
+        // マップした領域は、ファイルを閉じても有効。
+        ::close(fd);
+#endif
+        if (mData == 0) {
+            close();
+            return false;
+        }
+        mHasIndex = readIndex();
+        if (!mHasIndex && !scanStages()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /// ファイルを閉じます。
+    void RecordFile::close()
+    {
+#ifdef _WIN32
+        if (mData != 0) {
+            UnmapViewOfFile(mData);
+        }
+        if (mMappingHandle != 0) {
+            CloseHandle(mMappingHandle);
+            mMappingHandle = 0;
+        }
+        if (mFileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(mFileHandle);
+            mFileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (mData != 0) {
+            munmap(const_cast<char*>(mData), mSize);
+        }
+#endif
+        mData = 0;
+        mSize = 0;
+        mIndex.reset();
+        mHasIndex = false;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return ファイルを開いている場合は @c true 。
+    bool RecordFile::isOpen()const
+    {
+        return mData != 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return ファイルの末尾に索引があった場合は @c true 。
+    ///         @c false の場合、索引には位置と長さだけが入っています。
+    bool RecordFile::hasIndex()const
+    {
+        return mHasIndex;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return ファイルの大きさ [byte] 。
+    int RecordFile::fileSize()const
+    {
+        return mSize;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 索引に含まれるステージ数。
+    int RecordFile::stageCount()const
+    {
+        return mIndex.count();
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aStageIndex ステージ番号。
+    ///
+    /// @return 指定したステージの索引。
+    const RecordIndex::Entry& RecordFile::entry(int aStageIndex)const
+    {
+        return mIndex.entry(aStageIndex);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 指定したステージの部分だけを解釈し、記録を復元します。
+    ///
+    /// @param[in]  aStageIndex ステージ番号。
+    /// @param[out] aStage      復元先。
+    ///
+    /// @return 復元できた場合は @c true 。
+    bool RecordFile::loadStage(int aStageIndex, RecordStage& aStage)const
+    {
+        HPC_ASSERT(isOpen());
+        const RecordIndex::Entry& stageEntry = mIndex.entry(aStageIndex);
+        const char* const begin = mData + stageEntry.offset;
+        JsonReader reader(begin, begin + stageEntry.length);
+        return mHasIndex ? aStage.readJson(reader, stageEntry.endState) : aStage.readJson(reader);
+    }
+
+    //------------------------------------------------------------------------------
+    /// ファイルの末尾にある索引の位置を読み、索引を読み取ります。
+    ///
+    /// @return 索引を読み取れ、各ステージの範囲がファイル内に収まっている場合は @c true 。
+    bool RecordFile::readIndex()
+    {
+        // 末尾の "索引の位置]" を後ろから読む。
+        int pos = mSize;
+        while (pos > 0 && (mData[pos - 1] == '\n' || mData[pos - 1] == '\r' || mData[pos - 1] == ' ')) {
+            --pos;
+        }
+        if (pos == 0 || mData[pos - 1] != ']') {
+            return false;
+        }
+        --pos;
+        while (pos > 0 && (mData[pos - 1] == '\n' || mData[pos - 1] == '\r' || mData[pos - 1] == ' ')) {
+            --pos;
+        }
+        const int digitEnd = pos;
+        while (pos > 0 && '0' <= mData[pos - 1] && mData[pos - 1] <= '9') {
+            --pos;
+        }
+        int indexOffset = 0;
+        JsonReader offsetReader(mData + pos, mData + digitEnd);
+        if (!offsetReader.readInt(indexOffset) || indexOffset < 0 || pos <= indexOffset) {
+            return false;
+        }
+
+        JsonReader indexReader(mData + indexOffset, mData + pos);
+        if (!mIndex.read(indexReader)) {
+            return false;
+        }
+        for (int index = 0; index < mIndex.count(); ++index) {
+            const RecordIndex::Entry& stageEntry = mIndex.entry(index);
+            if (stageEntry.offset < 0 || stageEntry.length < 0 || indexOffset < stageEntry.offset + stageEntry.length) {
+                mIndex.reset();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 索引の無いファイルについて、ステージ情報の配列を先頭から走査し、
+    /// 各ステージの位置と長さだけを索引に入れます。ステージの中身は解釈しません。
+    ///
+    /// @return ステージ情報の配列を最後まで走査できた場合は @c true 。
+    bool RecordFile::scanStages()
+    {
+        mIndex.reset();
+        JsonReader reader(mData, mData + mSize);
+        reader.expect('[');
+        // 基本情報
+        reader.skipArray();
+        reader.expect(',');
+        // ステージ情報
+        reader.expect('[');
+        while (reader.isOk() && !reader.isNext(']')) {
+            if (mIndex.count() > 0) {
+                reader.expect(',');
+            }
+            if (mIndex.count() >= Parameter::GameStageCount || !reader.isNext('[')) {
+                mIndex.reset();
+                return false;
+            }
+            const char* const begin = reader.position();
+            if (!reader.skipArray()) {
+                break;
+            }
+            mIndex.add(static_cast<int>(begin - mData), static_cast<int>(reader.position() - begin), -1, -1, StageState_Playing);
+        }
+        if (!reader.expect(']')) {
+            mIndex.reset();
+            return false;
+        }
+        return true;
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
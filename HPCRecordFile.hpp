@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    RecordIndex, RecordFile クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "HPCParameter.hpp"
+#include "HPCStageState.hpp"
+
+namespace hpc {
+
+    class JsonReader;
+    class JsonWriter;
+    class RecordStage;
+
+    //------------------------------------------------------------------------------
+    /// @brief JSON ファイル内の、ステージごとの位置を表す索引です。
+    ///
+    /// 索引はトップレベルの配列の 3 番目の要素として、ステージ情報の後に出力します。
+    /// 最後の要素は索引の先頭の位置 (ファイル先頭からの文字数) で、
+    /// ファイルの末尾から読むことで、全体を解釈せずに索引を見つけられます。
+    ///
+    /// @code
+    /// [ [基本情報], [ステージ, ...], [[位置, 長さ, 得点, ターン数, 終了状態], ...], 索引の位置 ]
+    /// @endcode
+    ///
+    /// ビューアは 1, 2 番目の要素だけを読むので、索引付きのファイルもそのまま読み込めます。
+    class RecordIndex
+    {
+    public:
+        /// ステージ 1 つ分の索引
+        struct Entry
+        {
+            int offset;         ///< ステージの JSON の位置 [文字]
+            int length;         ///< ステージの JSON の長さ [文字]
+            int score;          ///< 得点
+            int turnCount;      ///< 記録しているターン数
+            StageState endState;///< 終了時の状態
+        };
+
+        RecordIndex();
+
+        void reset();                                       ///< 索引を空にします。
+        void add(int aOffset, int aLength, int aScore, int aTurnCount, StageState aEndState); ///< 索引を追加します。
+        int count()const;                                  ///< 索引の数を返します。
+        const Entry& entry(int aStageIndex)const;          ///< 索引を返します。
+
+        void write(JsonWriter& aWriter)const;              ///< 索引を出力します。
+        bool read(JsonReader& aReader);                     ///< 索引を読み取ります。
+
+    private:
+        Entry mEntries[Parameter::GameStageCount];         ///< ステージごとの索引
+        int mCount;                                         ///< 索引の数
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief 索引付きで出力された JSON ファイルを、ステージ単位で読み出します。
+    ///
+    /// ファイルはメモリにマップし、指定されたステージの部分だけを解釈します。
+    /// 索引の無いファイル (-j, -jd の出力) は、開くときにステージ情報の括弧だけを走査して位置を求めます。
+    /// その場合、索引の得点とターン数は -1 で、終了時の状態は読み出すときに最後のターンから推定します。
+    class RecordFile
+    {
+    public:
+        RecordFile();
+        ~RecordFile();
+
+        bool open(const char* aFileName);                   ///< ファイルを開き、索引を読み取ります。
+        void close();                                       ///< ファイルを閉じます。
+        bool isOpen()const;                                ///< ファイルを開いているかどうかを返します。
+        bool hasIndex()const;                              ///< ファイルに索引があったかどうかを返します。
+
+        int fileSize()const;                               ///< ファイルの大きさを返します。
+        int stageCount()const;                             ///< ステージ数を返します。
+        const RecordIndex::Entry& entry(int aStageIndex)const; ///< ステージの索引を返します。
+        bool loadStage(int aStageIndex, RecordStage& aStage)const; ///< ステージの記録を読み出します。
+
+    private:
+        const char* mData;                                  ///< マップしたファイルの先頭
+        int mSize;                                          ///< ファイルの大きさ
+        RecordIndex mIndex;                                 ///< 索引
+        bool mHasIndex;                                     ///< ファイルに索引があったか
+#ifdef _WIN32
+        void* mFileHandle;                                  ///< ファイルのハンドル
+        void* mMappingHandle;                               ///< マッピングのハンドル
+#endif
+
+        bool readIndex();                                   ///< ファイルの末尾から索引を読み取ります。
+        bool scanStages();                                  ///< 索引の無いファイルから、ステージの位置を求めます。
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,28 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    RecordLevel 列挙型
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief 実行結果をどこまで記録するかを表します。
+    ///
+    /// どのレベルでも、得点の計算に必要な情報は記録されます。
+    enum RecordLevel {
+        RecordLevel_Score,      ///< 得点のみ。ターンごとのキャラ情報を作成・保存しない
+        RecordLevel_Summary,    ///< ステージごとの情報 (フィールド・蓮・開始位置・順位) まで
+        RecordLevel_Full,       ///< 全ターンのキャラ情報まで
+
+        RecordLevel_TERM
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
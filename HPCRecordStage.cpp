@@ -12,6 +12,8 @@
 #include "HPCRecordStage.hpp"
 
 #include "HPCCommon.hpp"
+#include "HPCJsonReader.hpp"
+#include "HPCJsonWriter.hpp"
 #include "HPCLevelDesigner.hpp"
 
 namespace hpc {
@@ -19,10 +21,12 @@ namespace hpc {
     //------------------------------------------------------------------------------
     /// クラスのインスタンスを生成します。
     RecordStage::RecordStage()
-        : mCurrentTurn(0)
+        : mLevel(RecordLevel_Full)
+        , mCurrentTurn(0)
         , mRanks()
         , mPassedLotusCount(0)
         , mCharaCount(0)
+        , mSolverStats()
 #ifdef DEBUG
         , mTurns()
         , mField()
@@ -30,9 +34,23 @@ namespace hpc {
         , mInitPositions()
 #endif
         , mIsFailed(false)
+        , mEndState(StageState_Playing)
     {
     }
 
+    //------------------------------------------------------------------------------
+    /// どこまで記録するかを設定します。記録を開始する前に呼び出します。
+    ///
+    /// どのレベルでも score() は同じ値を返します。
+    /// RecordLevel_Full 未満の場合、 dump や dumpJson はターンの情報を出力しません。
+    ///
+    /// @param[in] aLevel 記録レベル。
+    void RecordStage::setLevel(RecordLevel aLevel)
+    {
+        HPC_ENUM_ASSERT(RecordLevel, aLevel);
+        mLevel = aLevel;
+    }
+
     //------------------------------------------------------------------------------
     /// ステージの記録を開始することを通知します。
     ///
@@ -42,6 +60,9 @@ namespace hpc {
         mCharaCount = aStage.charas().count();
         
 #ifdef DEBUG
+        if (mLevel == RecordLevel_Score) {
+            return;
+        }
         mField.set(aStage.field());
         mLotuses.set(aStage.lotuses());
         for (int index = 0; index < mCharaCount; ++index) {
@@ -57,10 +78,13 @@ namespace hpc {
     void RecordStage::writeTurn(const TurnResult& aResult)
     {
 #ifdef DEBUG
-        HPC_RANGE_ASSERT_MIN_UB_I(mCurrentTurn, 0, HPC_ARRAY_NUM(mTurns));
-        mTurns[mCurrentTurn].set(aResult);
+        if (mLevel == RecordLevel_Full) {
+            HPC_RANGE_ASSERT_MIN_UB_I(mCurrentTurn, 0, HPC_ARRAY_NUM(mTurns));
+            mTurns[mCurrentTurn].encode(aResult);
+        }
 #endif
         ++mCurrentTurn;
+        mEndState = aResult.state;
         // 得点計算のため、失敗したことを記録しておく。
         if (
             aResult.state == StageState_Failed
@@ -83,6 +107,9 @@ namespace hpc {
         // 通過した蓮の数を計算
         const Chara& player = aStage.charas()[0];
         mPassedLotusCount = player.passedLotusCount();
+
+        // 解答プログラムの統計情報を保存
+        mSolverStats = SolverStats::Current();
     }
 
     //------------------------------------------------------------------------------
@@ -117,6 +144,27 @@ namespace hpc {
         return totalScore;
     }
 
+    //------------------------------------------------------------------------------
+    /// @return writeEnd 時点で記録された、解答プログラムの探索に関する統計情報。
+    const SolverStats& RecordStage::solverStats()const
+    {
+        return mSolverStats;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return mTurns に記録されているターン数。 RecordLevel_Full でなければ 0 。
+    int RecordStage::recordedTurnCount()const
+    {
+        return mLevel == RecordLevel_Full ? mCurrentTurn : 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 最後に記録したターンの状態。
+    StageState RecordStage::endState()const
+    {
+        return mEndState;
+    }
+
     //------------------------------------------------------------------------------
     /// 記録された結果を画面に出力します。
     void RecordStage::dump()const
@@ -134,8 +182,9 @@ namespace hpc {
             HPC_PRINT_LOG("Lotus", "#%3d: (%7.2f,%7.2f) R=%7.2f\n", 
                 index, lotusRegion.pos().x, lotusRegion.pos().y, lotusRegion.radius());
         }
-        for (int index = 0; index < mCurrentTurn; ++index) {
-            const TurnResult& turn = mTurns[index];
+        for (int index = 0; index < recordedTurnCount(); ++index) {
+            TurnResult turn;
+            mTurns[index].decode(turn);
             HPC_PRINT_LOG("Turn", "#%04d: ", index);
             switch(turn.state) {
             case StageState_Playing:
@@ -170,160 +219,440 @@ namespace hpc {
             }
         }
 #endif
+        mSolverStats.dump();
         HPC_PRINT_LOG("Score", "%d\n", static_cast<int>(score()));
     }
 
     //------------------------------------------------------------------------------
     /// 記録された結果をJSON形式で出力します。
     ///
+    /// @param[in] aWriter      出力先。
     /// @param[in] isCompressed 圧縮された状態で出力するかどうか。
     ///                         @c true にすると、改行やインデントを除いた形で出力されます。
-    void RecordStage::dumpJson(bool isCompressed)const
+    void RecordStage::dumpJson(JsonWriter& aWriter, bool isCompressed)const
     {
 #ifdef DEBUG
-        HPC_PRINT_JSON_DEBUG(!isCompressed, "        "); // インデント (8)
-        HPC_PRINT("[");
-        HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+        aWriter.putIf(!isCompressed, "        "); // インデント (8)
+        aWriter.put("[");
+        aWriter.putIf(!isCompressed, "\n");
 
             // 初期状態情報
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "            "); // インデント (12)
-            HPC_PRINT("[");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            aWriter.putIf(!isCompressed, "            "); // インデント (12)
+            aWriter.put("[");
+            aWriter.putIf(!isCompressed, "\n");
 
                 // フィールド情報
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("%7.3f,%7.3f,", mField.rect().width(), mField.rect().height());
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.putFixed3(mField.rect().width());
+                aWriter.put(',');
+                aWriter.putFixed3(mField.rect().height());
+                aWriter.put(',');
+                aWriter.putIf(!isCompressed, "\n");
 
                 // 蓮情報
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("[");
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.put("[");
+                aWriter.putIf(!isCompressed, "\n");
 
                 for (int lotusIndex = 0; lotusIndex < mLotuses.count(); ++lotusIndex) {
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "                    "); // インデント (20)
-                    HPC_PRINT("[");
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-                        HPC_PRINT_JSON_DEBUG(!isCompressed, "                        "); // インデント (24)
-                        HPC_PRINT(
-                            "%7.3f,%7.3f,%7.3f"
-                            , mLotuses[lotusIndex].pos().x
-                            , mLotuses[lotusIndex].pos().y
-                            , mLotuses[lotusIndex].radius()
-                            );
-                        HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "                    "); // インデント (20)
-                    HPC_PRINT("]");
+                    aWriter.putIf(!isCompressed, "                    "); // インデント (20)
+                    aWriter.put("[");
+                    aWriter.putIf(!isCompressed, "\n");
+                        aWriter.putIf(!isCompressed, "                        "); // インデント (24)
+                        aWriter.putFixed3(mLotuses[lotusIndex].pos().x);
+                        aWriter.put(',');
+                        aWriter.putFixed3(mLotuses[lotusIndex].pos().y);
+                        aWriter.put(',');
+                        aWriter.putFixed3(mLotuses[lotusIndex].radius());
+                        aWriter.putIf(!isCompressed, "\n");
+                    aWriter.putIf(!isCompressed, "                    "); // インデント (20)
+                    aWriter.put("]");
                     if (lotusIndex + 1 < mLotuses.count()) {
-                        HPC_PRINT(",");
+                        aWriter.put(",");
                     }
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                    aWriter.putIf(!isCompressed, "\n");
                 }
 
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("],");
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.put("],");
+                aWriter.putIf(!isCompressed, "\n");
 
                 // 順位情報
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("[");
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.put("[");
+                aWriter.putIf(!isCompressed, "\n");
 
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "                    "); // インデント (20)
+                    aWriter.putIf(!isCompressed, "                    "); // インデント (20)
                     for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
-                        HPC_PRINT("%d", mRanks[charaIndex]);
+                        aWriter.putInt(mRanks[charaIndex]);
                         if (charaIndex < mCharaCount - 1) {
-                            HPC_PRINT(", ");
+                            aWriter.put(", ");
                         }
                     }
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                    aWriter.putIf(!isCompressed, "\n");
 
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("],");
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.put("],");
+                aWriter.putIf(!isCompressed, "\n");
 
                 // 流れる速度
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("%7.6f,", mField.flowVel().y);
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.putFixed(mField.flowVel().y, 7, 6);
+                aWriter.put(',');
+                aWriter.putIf(!isCompressed, "\n");
 
                 // スコア
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("%d", static_cast<int>(score()));
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.putInt(static_cast<int>(score()));
+                aWriter.putIf(!isCompressed, "\n");
 
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "            "); // インデント (12)
-            HPC_PRINT("],");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            aWriter.putIf(!isCompressed, "            "); // インデント (12)
+            aWriter.put("],");
+            aWriter.putIf(!isCompressed, "\n");
 
             // ターン情報
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "            "); // インデント (12)
-            HPC_PRINT("[");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            aWriter.putIf(!isCompressed, "            "); // インデント (12)
+            aWriter.put("[");
+            aWriter.putIf(!isCompressed, "\n");
 
-            for (int turn = 0; turn < mCurrentTurn; ++turn) {
-                const TurnResult& s = mTurns[turn];
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("[");
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            for (int turn = 0; turn < recordedTurnCount(); ++turn) {
+                TurnResult s;
+                mTurns[turn].decode(s);
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.put("[");
+                aWriter.putIf(!isCompressed, "\n");
 
                     // キャラ情報
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "                    "); // インデント (20)
-                    HPC_PRINT("[");
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                    aWriter.putIf(!isCompressed, "                    "); // インデント (20)
+                    aWriter.put("[");
+                    aWriter.putIf(!isCompressed, "\n");
 
                     for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
-                        HPC_PRINT_JSON_DEBUG(!isCompressed, "                        "); // インデント (24)
-                        HPC_PRINT("[");
-                        HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-                            HPC_PRINT_JSON_DEBUG(!isCompressed, "                            "); // インデント (28)
-                            HPC_PRINT(
-                                "%7.3f,%7.3f,"
-                                , s.charas[charaIndex].pos.x
-                                , s.charas[charaIndex].pos.y
-                                );
-                            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-                            HPC_PRINT_JSON_DEBUG(!isCompressed, "                            "); // インデント (28)
-                            HPC_PRINT(
-                                "%d,"
-                                , s.charas[charaIndex].accelCount
-                                );
-                            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-                            HPC_PRINT_JSON_DEBUG(!isCompressed, "                            "); // インデント (28)
-                            HPC_PRINT(
-                                "%d"
-                                , s.charas[charaIndex].passedLotusCount
-                                );
-                            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
-                        HPC_PRINT_JSON_DEBUG(!isCompressed, "                        "); // インデント (24)
-                        HPC_PRINT("]");
+                        aWriter.putIf(!isCompressed, "                        "); // インデント (24)
+                        aWriter.put("[");
+                        aWriter.putIf(!isCompressed, "\n");
+                            aWriter.putIf(!isCompressed, "                            "); // インデント (28)
+                            aWriter.putFixed3(s.charas[charaIndex].pos.x);
+                            aWriter.put(',');
+                            aWriter.putFixed3(s.charas[charaIndex].pos.y);
+                            aWriter.put(',');
+                            aWriter.putIf(!isCompressed, "\n");
+                            aWriter.putIf(!isCompressed, "                            "); // インデント (28)
+                            aWriter.putInt(s.charas[charaIndex].accelCount);
+                            aWriter.put(',');
+                            aWriter.putIf(!isCompressed, "\n");
+                            aWriter.putIf(!isCompressed, "                            "); // インデント (28)
+                            aWriter.putInt(s.charas[charaIndex].passedLotusCount);
+                            aWriter.putIf(!isCompressed, "\n");
+                        aWriter.putIf(!isCompressed, "                        "); // インデント (24)
+                        aWriter.put("]");
                         if (charaIndex + 1 < mCharaCount) {
-                            HPC_PRINT(",");
+                            aWriter.put(",");
                         }
-                        HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                        aWriter.putIf(!isCompressed, "\n");
                     }
 
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "                    "); // インデント (20)
-                    HPC_PRINT("]");
-                    HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                    aWriter.putIf(!isCompressed, "                    "); // インデント (20)
+                    aWriter.put("]");
+                    aWriter.putIf(!isCompressed, "\n");
 
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "                "); // インデント (16)
-                HPC_PRINT("]");
-                if (turn + 1 < mCurrentTurn) {
-                    HPC_PRINT(",");
+                aWriter.putIf(!isCompressed, "                "); // インデント (16)
+                aWriter.put("]");
+                if (turn + 1 < recordedTurnCount()) {
+                    aWriter.put(",");
                 }
-                HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+                aWriter.putIf(!isCompressed, "\n");
             }
 
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "            "); // インデント (12)
-            HPC_PRINT("]");
-            HPC_PRINT_JSON_DEBUG(!isCompressed, "\n");
+            aWriter.putIf(!isCompressed, "            "); // インデント (12)
+            aWriter.put("]");
+            aWriter.putIf(!isCompressed, "\n");
 
-        HPC_PRINT_JSON_DEBUG(!isCompressed, "        "); // インデント (8)
-        HPC_PRINT("]");
+        aWriter.putIf(!isCompressed, "        "); // インデント (8)
+        aWriter.put("]");
 #else
         // デバッグ無効の場合、json 出力はサポートされません。
-        HPC_PRINT("[]");
+        aWriter.put("[]");
+#endif
+    }
+
+    //------------------------------------------------------------------------------
+    /// 実行結果を、ビューアが型付き配列として直接読める形式で書き出します。
+    ///
+    /// 値はすべてリトルエンディアンで、次の順に並びます。
+    /// 各区間の先頭が 4 バイト境界に揃うよう、最後に 0 で埋めます。
+    ///
+    ///   型                                 | 内容
+    ///  ------------------------------------|------------------------------------
+    ///   int32 x 4                          | キャラ数 C, 蓮の数 L, ターン数 T, スコア
+    ///   float32 x 3                        | フィールドの幅, 高さ, 流れる速度
+    ///   int32 x C                          | 順位
+    ///   float32 x L x 3                    | 蓮の x, y, 半径
+    ///   float32 x T x C x 2                | キャラの x, y
+    ///   uint8 x T x C                      | 加速回数
+    ///   uint8 x T x C                      | 通過した蓮の数
+    ///
+    /// 位置は dumpJson と同じく、 CompactTurnResult から復元した値です。
+    ///
+    /// @param[in] aFile 出力先。
+    ///
+    /// @return 書き出しに成功した場合は @c true 。
+    bool RecordStage::writeBinary(std::FILE* aFile)const
+    {
+#ifdef DEBUG
+        const int lotusCount = mLotuses.count();
+        const int turnCount = recordedTurnCount();
+        const float fieldInfo[] = { mField.rect().width(), mField.rect().height(), mField.flowVel().y };
+#else
+        // デバッグ無効の場合、フィールドとターンの情報は出力されません。
+        const int lotusCount = 0;
+        const int turnCount = 0;
+        const float fieldInfo[] = { 0.0f, 0.0f, 0.0f };
+#endif
+        const int counts[] = { mCharaCount, lotusCount, turnCount, static_cast<int>(score()) };
+        bool isSucceeded = std::fwrite(counts, sizeof(counts), 1, aFile) == 1
+            && std::fwrite(fieldInfo, sizeof(fieldInfo), 1, aFile) == 1
+            && std::fwrite(mRanks, sizeof(int), mCharaCount, aFile) == static_cast<size_t>(mCharaCount);
+#ifdef DEBUG
+        for (int index = 0; isSucceeded && index < lotusCount; ++index) {
+            const float lotus[] = { mLotuses[index].pos().x, mLotuses[index].pos().y, mLotuses[index].radius() };
+            isSucceeded = std::fwrite(lotus, sizeof(lotus), 1, aFile) == 1;
+        }
+        // 区間ごとに連続させるため、ターンを 3 回たどる。
+        TurnResult result;
+        for (int turn = 0; isSucceeded && turn < turnCount; ++turn) {
+            float pos[Parameter::CharaCountMax * 2];
+            mTurns[turn].decode(result);
+            for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
+                pos[charaIndex * 2] = result.charas[charaIndex].pos.x;
+                pos[charaIndex * 2 + 1] = result.charas[charaIndex].pos.y;
+            }
+            isSucceeded = std::fwrite(pos, sizeof(float) * 2, mCharaCount, aFile) == static_cast<size_t>(mCharaCount);
+        }
+        for (int turn = 0; isSucceeded && turn < turnCount; ++turn) {
+            unsigned char accelCounts[Parameter::CharaCountMax];
+            mTurns[turn].decode(result);
+            for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
+                accelCounts[charaIndex] = static_cast<unsigned char>(result.charas[charaIndex].accelCount);
+            }
+            isSucceeded = std::fwrite(accelCounts, 1, mCharaCount, aFile) == static_cast<size_t>(mCharaCount);
+        }
+        for (int turn = 0; isSucceeded && turn < turnCount; ++turn) {
+            unsigned char passedLotusCounts[Parameter::CharaCountMax];
+            mTurns[turn].decode(result);
+            for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
+                passedLotusCounts[charaIndex] = static_cast<unsigned char>(result.charas[charaIndex].passedLotusCount);
+            }
+            isSucceeded = std::fwrite(passedLotusCounts, 1, mCharaCount, aFile) == static_cast<size_t>(mCharaCount);
+        }
+#endif
+        const int paddingSize = (4 - turnCount * mCharaCount * 2 % 4) % 4;
+        const unsigned char padding[4] = {};
+        return isSucceeded && std::fwrite(padding, 1, paddingSize, aFile) == static_cast<size_t>(paddingSize);
+    }
+
+    //------------------------------------------------------------------------------
+    /// dumpJson で出力した 1 ステージ分の JSON を読み取り、記録を復元します。
+    ///
+    /// JSON に含まれない探索の統計情報は空になります。
+    /// 位置は 0.001 単位で出力されているので、 dump で小数第 2 位へ丸めて表示する場合、
+    /// 1 の位が 5 の値は元の値と丸めの向きが異なることがあります。
+    ///
+    /// 終了時の状態は JSON に含まれないので、最後のターンから推定します。
+    /// 索引付きのファイルでは、索引に記録した状態を与える readJson を使います。
+    ///
+    /// @param[in] aReader ステージ 1 つ分の JSON を指す読み取りクラス。
+    ///
+    /// @return 復元できた場合は @c true 。
+    bool RecordStage::readJson(JsonReader& aReader)
+    {
+#ifdef DEBUG
+        *this = RecordStage();
+
+        aReader.expect('[');
+
+            // 初期状態情報
+            aReader.expect('[');
+
+                // フィールド情報
+                float width = 0.0f;
+                float height = 0.0f;
+                aReader.readFloat(width);
+                aReader.expect(',');
+                aReader.readFloat(height);
+                aReader.expect(',');
+
+                // 蓮情報
+                aReader.expect('[');
+                while (aReader.isOk() && !aReader.isNext(']')) {
+                    if (mLotuses.count() > 0) {
+                        aReader.expect(',');
+                    }
+                    if (mLotuses.count() >= Parameter::LotusCountMax) {
+                        return false;
+                    }
+                    Vec2 pos;
+                    float radius = 0.0f;
+                    aReader.expect('[');
+                    aReader.readFloat(pos.x);
+                    aReader.expect(',');
+                    aReader.readFloat(pos.y);
+                    aReader.expect(',');
+                    aReader.readFloat(radius);
+                    aReader.expect(']');
+                    mLotuses.setupAddLotus(pos, radius);
+                }
+                aReader.expect(']');
+                aReader.expect(',');
+
+                // 順位情報
+                aReader.expect('[');
+                while (aReader.isOk() && !aReader.isNext(']')) {
+                    if (mCharaCount > 0) {
+                        aReader.expect(',');
+                    }
+                    if (mCharaCount >= Parameter::CharaCountMax) {
+                        return false;
+                    }
+                    aReader.readInt(mRanks[mCharaCount++]);
+                }
+                aReader.expect(']');
+                aReader.expect(',');
+
+                // 流れる速度
+                float flowVelY = 0.0f;
+                aReader.readFloat(flowVelY);
+                aReader.expect(',');
+                mField.setup(Rectangle(0.0f, width, 0.0f, height), Vec2(0.0f, flowVelY));
+
+                // スコアは再計算するので読み飛ばす
+                int score = 0;
+                aReader.readInt(score);
+
+            aReader.expect(']');
+            aReader.expect(',');
+
+            // ターン情報
+            aReader.expect('[');
+            while (aReader.isOk() && !aReader.isNext(']')) {
+                if (mCurrentTurn > 0) {
+                    aReader.expect(',');
+                }
+                if (mCurrentTurn >= HPC_ARRAY_NUM(mTurns)) {
+                    return false;
+                }
+                TurnResult result;
+                result.state = StageState_Playing;
+                aReader.expect('[');
+                aReader.expect('[');
+                for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
+                    if (charaIndex > 0) {
+                        aReader.expect(',');
+                    }
+                    TurnResult::Chara& chara = result.charas[charaIndex];
+                    aReader.expect('[');
+                    aReader.readFloat(chara.pos.x);
+                    aReader.expect(',');
+                    aReader.readFloat(chara.pos.y);
+                    aReader.expect(',');
+                    aReader.readInt(chara.accelCount);
+                    aReader.expect(',');
+                    aReader.readInt(chara.passedLotusCount);
+                    aReader.expect(']');
+                }
+                aReader.expect(']');
+                aReader.expect(']');
+                if (mCurrentTurn == 0) {
+                    for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
+                        mInitPositions[charaIndex] = result.charas[charaIndex].pos;
+                    }
+                }
+                mPassedLotusCount = result.charas[0].passedLotusCount;
+                mTurns[mCurrentTurn++].encode(result);
+            }
+            aReader.expect(']');
+
+        aReader.expect(']');
+
+        if (!aReader.isOk() || !aReader.isEnd()) {
+            return false;
+        }
+        setEndState(inferEndState());
+        return true;
+#else
+        // デバッグ無効の場合、json 出力はサポートされません。
+        (void)aReader;
+        return false;
+#endif
+    }
+
+    //------------------------------------------------------------------------------
+    /// dumpJson で出力した 1 ステージ分の JSON を読み取り、記録を復元します。
+    ///
+    /// @param[in] aReader   ステージ 1 つ分の JSON を指す読み取りクラス。
+    /// @param[in] aEndState 終了時の状態。索引に記録したものを与えます。
+    ///
+    /// @return 復元できた場合は @c true 。
+    bool RecordStage::readJson(JsonReader& aReader, StageState aEndState)
+    {
+        HPC_ENUM_ASSERT(StageState, aEndState);
+        if (!readJson(aReader)) {
+            return false;
+        }
+        setEndState(aEndState);
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 最後のターンの位置と通過した蓮の数から、終了時の状態を Stage::runTurn と同じ順に判定します。
+    /// 人間キャラは先頭の 1 人です。
+    ///
+    /// @return 推定した終了時の状態。判定できない場合は StageState_Playing 。
+    StageState RecordStage::inferEndState()const
+    {
+#ifdef DEBUG
+        if (mCurrentTurn == 0) {
+            return StageState_Playing;
+        }
+        TurnResult result;
+        mTurns[mCurrentTurn - 1].decode(result);
+        const int goalLotusCount = mLotuses.count() * Parameter::StageRoundCount;
+        if (result.charas[0].passedLotusCount >= goalLotusCount) {
+            return StageState_Complete;
+        }
+        int goalCount = 0;
+        for (int charaIndex = 0; charaIndex < mCharaCount; ++charaIndex) {
+            if (result.charas[charaIndex].passedLotusCount >= goalLotusCount) {
+                ++goalCount;
+            }
+        }
+        if (goalCount == mCharaCount - 1) {
+            return StageState_Failed;
+        }
+        // 記録したターンには初期状態を含む。
+        if (mCurrentTurn - 1 >= Parameter::GameTurnPerStage) {
+            return StageState_TurnLimit;
+        }
+#endif
+        return StageState_Playing;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 終了時の状態を設定し、最後のターンの状態に反映します。
+    ///
+    /// @param[in] aEndState 終了時の状態。
+    void RecordStage::setEndState(StageState aEndState)
+    {
+        mEndState = aEndState;
+        mIsFailed = aEndState == StageState_Failed || aEndState == StageState_TurnLimit;
+#ifdef DEBUG
+        // 最後のターンだけが終了時の状態になる。
+        if (mCurrentTurn > 0) {
+            TurnResult result;
+            mTurns[mCurrentTurn - 1].decode(result);
+            result.state = aEndState;
+            mTurns[mCurrentTurn - 1].encode(result);
+        }
 #endif
     }
 }
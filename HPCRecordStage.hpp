@@ -10,13 +10,20 @@
 //------------------------------------------------------------------------------
 #pragma once
 
+#include <cstdio>
+#include "HPCCompactTurnResult.hpp"
 #include "HPCField.hpp"
 #include "HPCParameter.hpp"
+#include "HPCRecordLevel.hpp"
+#include "HPCSolverStats.hpp"
 #include "HPCStage.hpp"
 #include "HPCTurnResult.hpp"
 
 namespace hpc {
 
+    class JsonReader;
+    class JsonWriter;
+
     //------------------------------------------------------------------------------
     /// @brief 各ステージの記録を表します。
     class RecordStage 
@@ -24,28 +31,41 @@ namespace hpc {
     public:
         RecordStage();
 
+        void setLevel(RecordLevel aLevel);                  ///< 記録レベルを設定します。
         void writeStart(const Stage& aStage);               ///< 記録を開始します。
         void writeTurn(const TurnResult& aResult);          ///< 各ターンの内容を記録します。
         void writeEnd(const Stage& aStage);                 ///< 終了時の内容を記録します。
 
         double score()const;                               ///< ステージ毎の得点を返します。
+        int recordedTurnCount()const;                      ///< 記録しているターン数を返します。
+        StageState endState()const;                        ///< 終了時の状態を返します。
+        const SolverStats& solverStats()const;             ///< 解答プログラムの探索に関する統計情報を返します。
         void dump()const;                                  ///< 実行結果を画面に表示します。
-        void dumpJson(bool aIsCompressed)const;            ///< 実行結果を JSON 形式で画面に表示します。
+        void dumpJson(JsonWriter& aWriter, bool aIsCompressed)const; ///< 実行結果を JSON 形式で画面に表示します。
+        bool readJson(JsonReader& aReader);                 ///< dumpJson で出力した JSON から記録を復元します。
+        bool readJson(JsonReader& aReader, StageState aEndState); ///< 終了時の状態を指定して、 JSON から記録を復元します。
+        bool writeBinary(std::FILE* aFile)const;           ///< 実行結果をビューア用のバイナリ形式で書き出します。
 
     private:
+        RecordLevel mLevel;                                 ///< 記録レベル
         int mCurrentTurn;                                   ///< 現在のターン番号
         int mRanks[Parameter::CharaCountMax];               ///< 順位
         int mPassedLotusCount;                              ///< 通過した蓮の数
         int mCharaCount;                                    ///< キャラ数
+        SolverStats mSolverStats;                           ///< 解答プログラムの探索に関する統計情報
         
         // 詳細な記録は、定数 DEBUG が定義されている場合にのみ表示されます。
 #ifdef DEBUG
-        TurnResult mTurns[Parameter::GameTurnPerStage + 1]; ///< 記録するターン。初期状態を含めるので1多くとる。
+        CompactTurnResult mTurns[Parameter::GameTurnPerStage + 1]; ///< 記録するターン。初期状態を含めるので1多くとる。
         Field mField;                                       ///< フィールド情報
         LotusCollection mLotuses;                           ///< 蓮情報
         Vec2 mInitPositions[Parameter::CharaCountMax];      ///< 開始位置
 #endif
         bool mIsFailed;     ///< ステージ途中で失敗したか
+        StageState mEndState;   ///< 最後に記録したターンの状態
+
+        StageState inferEndState()const;                   ///< 最後のターンから終了時の状態を推定します。
+        void setEndState(StageState aEndState);             ///< 終了時の状態を設定します。
     };
 }
 //------------------------------------------------------------------------------
@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCRecordStream.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCRecordStream.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include "HPCCommon.hpp"
+#include "HPCJsonWriter.hpp"
+#include "HPCTracer.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    RecordStream::RecordStream()
+        : mRecord(0)
+        , mFile(0)
+        , mFormat(JsonFormat_Compressed)
+        , mIndex()
+        , mThread()
+        , mQueue()
+        , mHead(0)
+        , mTail(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 出力スレッドが動いている場合、終了を待ってから破棄します。
+    RecordStream::~RecordStream()
+    {
+        finish();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 出力スレッドを開始します。シミュレーションを始める前に呼び出します。
+    ///
+    /// @param[in] aRecord      出力する記録。出力が終わるまで有効である必要があります。
+    /// @param[in] aFile        出力先。索引を付ける場合は、ファイルの先頭から書き始める必要があります。
+    /// @param[in] aFormat      出力形式。
+    void RecordStream::start(const Record& aRecord, std::FILE* aFile, JsonFormat aFormat)
+    {
+        HPC_ASSERT(!isRunning());
+        HPC_ENUM_ASSERT(JsonFormat, aFormat);
+        mRecord = &aRecord;
+        mFile = aFile;
+        mFormat = aFormat;
+        mIndex.reset();
+        mHead.store(0);
+        mTail.store(0);
+        mThread = std::thread(&RecordStream::threadMain, this);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 記録が終わったステージを出力に回します。ステージ番号の順に呼び出す必要があります。
+    ///
+    /// @param[in] aStageIndex 記録が終わったステージの番号。
+    void RecordStream::notifyStageDone(int aStageIndex)
+    {
+        HPC_ASSERT(isRunning());
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        push(aStageIndex);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 出力の終わりを伝え、出力スレッドが残りを出力し終えるまで待ちます。
+    void RecordStream::finish()
+    {
+        if (!isRunning()) {
+            return;
+        }
+        push(EndMark);
+        mThread.join();
+        std::fflush(mFile);
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 出力スレッドが動いている場合は @c true 。
+    bool RecordStream::isRunning()const
+    {
+        return mThread.joinable();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 待ち行列に値を入れます。一杯の場合は、出力スレッドが取り出すまで待ちます。
+    ///
+    /// @param[in] aValue 入れる値。
+    void RecordStream::push(int aValue)
+    {
+        const int tail = mTail.load(std::memory_order_relaxed);
+        while (tail - mHead.load(std::memory_order_acquire) >= QueueSize) {
+            std::this_thread::yield();
+        }
+        mQueue[tail % QueueSize] = aValue;
+        mTail.store(tail + 1, std::memory_order_release);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 待ち行列から値を取り出します。空の場合は、値が入るまで待ちます。
+    ///
+    /// @return 取り出した値。
+    int RecordStream::pop()
+    {
+        const int head = mHead.load(std::memory_order_relaxed);
+        while (mTail.load(std::memory_order_acquire) == head) {
+            // 1 ステージのシミュレーションには出力よりも時間がかかるので、
+            // 空いている間は CPU を使わないように休む。
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const int value = mQueue[head % QueueSize];
+        mHead.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 出力スレッドの処理です。終わりを表す値を取り出すまで、ステージを順に出力します。
+    void RecordStream::threadMain()
+    {
+        Tracer::NameThread("RecordWriter");
+        JsonWriter writer(mFile);
+        if (mFormat == JsonFormat_Lines) {
+            Record::writeJsonLinesHeader(writer);
+            for (int stageIndex = pop(); stageIndex != EndMark; stageIndex = pop()) {
+                Tracer::Begin("WriteStage", stageIndex);
+                mRecord->writeJsonLine(writer, stageIndex);
+                Tracer::End("WriteStage");
+            }
+            return;
+        }
+        const bool isCompressed = mFormat != JsonFormat_Pretty;
+        RecordIndex* const index = mFormat == JsonFormat_Indexed ? &mIndex : 0;
+        Record::writeJsonHeader(writer, isCompressed);
+        for (int stageIndex = pop(); stageIndex != EndMark; stageIndex = pop()) {
+            Tracer::Begin("WriteStage", stageIndex);
+            mRecord->writeJsonStage(writer, stageIndex, isCompressed, index);
+            Tracer::End("WriteStage");
+        }
+        Record::writeJsonFooter(writer, isCompressed, index);
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    RecordStream クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include "HPCJsonFormat.hpp"
+#include "HPCRecord.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief 記録が終わったステージから順に、別スレッドで JSON として出力します。
+    ///
+    /// シミュレーションを行うスレッドは、ステージが終わるたびに notifyStageDone で
+    /// ステージ番号を待ち行列に入れます。出力スレッドはそれを取り出して出力するので、
+    /// 出力は次のステージのシミュレーションと並行して行われます。
+    ///
+    /// 待ち行列は書き込み側と読み出し側が 1 つずつのリングバッファで、ロックを使いません。
+    /// 待ち行列が一杯の場合、 notifyStageDone は空きが出来るまで待ちます。
+    /// JsonFormat_Pretty と JsonFormat_Compressed の出力は Record::dumpJson と、
+    /// JsonFormat_Lines の出力は Record::dumpJsonLines と同じです。
+    class RecordStream
+    {
+    public:
+        RecordStream();
+        ~RecordStream();
+
+        void start(const Record& aRecord, std::FILE* aFile, JsonFormat aFormat); ///< 出力スレッドを開始します。
+        void notifyStageDone(int aStageIndex);              ///< 記録が終わったステージを出力に回します。
+        void finish();                                      ///< 残りを出力し、出力スレッドの終了を待ちます。
+        bool isRunning()const;                             ///< 出力スレッドが動いているかどうかを返します。
+
+    private:
+        static const int QueueSize = 4;                     ///< 待ち行列の大きさ
+        static const int EndMark = -1;                      ///< 出力の終わりを表す値
+
+        const Record* mRecord;                              ///< 出力する記録
+        std::FILE* mFile;                                   ///< 出力先
+        JsonFormat mFormat;                                 ///< 出力形式
+        RecordIndex mIndex;                                 ///< 出力したステージの索引
+        std::thread mThread;                                ///< 出力スレッド
+        int mQueue[QueueSize];                              ///< 出力するステージ番号の待ち行列
+        std::atomic<int> mHead;                             ///< 次に取り出す位置 (出力スレッドのみが書き換える)
+        std::atomic<int> mTail;                             ///< 次に入れる位置 (シミュレーション側のみが書き換える)
+
+        void push(int aValue);                              ///< 待ち行列に入れます。
+        int pop();                                          ///< 待ち行列から取り出します。
+        void threadMain();                                  ///< 出力スレッドの処理です。
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,27 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    ReplanReason 列挙型
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief 解答プログラムが探索し直した理由を表します。
+    enum ReplanReason {
+        ReplanReason_Initial,   ///< ステージ開始時の最初の探索
+        ReplanReason_Threshold, ///< 計画を一定の割合まで消化した
+        ReplanReason_Deviation, ///< 予測した位置からずれた
+        ReplanReason_Segment,   ///< 再利用した行動列を使い切り、続きが見つからなかった
+
+        ReplanReason_TERM
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
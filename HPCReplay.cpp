@@ -0,0 +1,402 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCReplay.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCReplay.hpp"
+
+#include <cstring>
+#include "HPCBrain.hpp"
+#include "HPCCommon.hpp"
+#include "HPCLevelDesigner.hpp"
+#include "HPCRandom.hpp"
+
+namespace {
+    using namespace hpc;
+
+    /// ファイルの先頭に置く識別子
+    const char FileMagic[4] = { 'H', 'P', 'C', 'R' };
+    /// ファイル形式のバージョン
+    const uint FileVersion = 1;
+
+    //------------------------------------------------------------------------------
+    /// FNV-1a でチェックサムにデータを加えます。
+    uint AddChecksum(uint aHash, const void* aData, int aSize)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(aData);
+        for (int index = 0; index < aSize; ++index) {
+            aHash = (aHash ^ bytes[index]) * 16777619u;
+        }
+        return aHash;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 値を 1 つ書き出します。
+    template <typename T>
+    bool WriteValue(std::FILE* aFile, const T& aValue)
+    {
+        return std::fwrite(&aValue, sizeof(T), 1, aFile) == 1;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 値を 1 つ読み込みます。
+    template <typename T>
+    bool ReadValue(std::FILE* aFile, T& aValue)
+    {
+        return std::fread(&aValue, sizeof(T), 1, aFile) == 1;
+    }
+}
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    ReplayStage::ReplayStage()
+        : mStageIndex(0)
+        , mSystemSeed()
+        , mGameSeed()
+        , mTurnCount(0)
+        , mActions()
+        , mChecksums()
+        , mEndChecksum(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージの記録を開始します。
+    /// ステージを生成する前に呼び出します。
+    ///
+    /// @param[in] aStageIndex ステージ番号。
+    /// @param[in] aSystem     ステージ生成前のシステム用乱数。
+    /// @param[in] aGame       ステージ開始時のゲーム用乱数。
+    void ReplayStage::writeStart(int aStageIndex, const Random& aSystem, const Random& aGame)
+    {
+        mStageIndex = aStageIndex;
+        mSystemSeed[0] = aSystem.seedX();
+        mSystemSeed[1] = aSystem.seedY();
+        mGameSeed[0] = aGame.seedX();
+        mGameSeed[1] = aGame.seedY();
+        mTurnCount = 0;
+        mEndChecksum = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// ターンを実行した後に呼び出し、そのターンのプレイヤーの動作を記録します。
+    ///
+    /// @param[in] aStage ターンを実行したステージ。
+    void ReplayStage::writeTurn(const Stage& aStage)
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(mTurnCount, 0, Parameter::GameTurnPerStage);
+        // 0 番のキャラが人間。人間がゴールした時点でステージは終わるので、
+        // 記録する動作は常にそのターンに実行されたものになる。
+        mActions[mTurnCount] = aStage.charas()[0].lastAction();
+        ++mTurnCount;
+        if (mTurnCount % ChecksumInterval == 0) {
+            mChecksums[mTurnCount / ChecksumInterval - 1] = Checksum(aStage.charas());
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージ終了時の状態のチェックサムを記録します。
+    ///
+    /// @param[in] aStage 終了したステージ。
+    void ReplayStage::writeEnd(const Stage& aStage)
+    {
+        mEndChecksum = Checksum(aStage.charas());
+    }
+
+    //------------------------------------------------------------------------------
+    int ReplayStage::stageIndex()const
+    {
+        return mStageIndex;
+    }
+
+    //------------------------------------------------------------------------------
+    Random ReplayStage::systemRandom()const
+    {
+        return Random(mSystemSeed[0], mSystemSeed[1]);
+    }
+
+    //------------------------------------------------------------------------------
+    Random ReplayStage::gameRandom()const
+    {
+        return Random(mGameSeed[0], mGameSeed[1]);
+    }
+
+    //------------------------------------------------------------------------------
+    int ReplayStage::turnCount()const
+    {
+        return mTurnCount;
+    }
+
+    //------------------------------------------------------------------------------
+    const Action* ReplayStage::actions()const
+    {
+        return mActions;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aTurn ターン数。 ChecksumInterval の倍数で、 turnCount() 以下である必要があります。
+    ///
+    /// @return aTurn ターン実行後の全キャラの状態のチェックサム。
+    uint ReplayStage::checksum(int aTurn)const
+    {
+        HPC_ASSERT(aTurn % ChecksumInterval == 0);
+        HPC_RANGE_ASSERT_MIN_MAX_I(aTurn, ChecksumInterval, mTurnCount);
+        return mChecksums[aTurn / ChecksumInterval - 1];
+    }
+
+    //------------------------------------------------------------------------------
+    uint ReplayStage::endChecksum()const
+    {
+        return mEndChecksum;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 記録をファイルに書き出します。
+    ///
+    /// 待機は種類のみ、加速は種類と目標座標を書き出します。
+    ///
+    /// @return 書き出しに成功した場合は @c true 。
+    bool ReplayStage::write(std::FILE* aFile)const
+    {
+        bool isSucceeded = WriteValue(aFile, mStageIndex)
+            && WriteValue(aFile, mSystemSeed)
+            && WriteValue(aFile, mGameSeed)
+            && WriteValue(aFile, mTurnCount);
+        for (int turn = 0; isSucceeded && turn < mTurnCount; ++turn) {
+            const Action& action = mActions[turn];
+            const unsigned char type = static_cast<unsigned char>(action.type());
+            isSucceeded = WriteValue(aFile, type);
+            if (isSucceeded && action.type() == ActionType_Accel) {
+                isSucceeded = WriteValue(aFile, action.value().x) && WriteValue(aFile, action.value().y);
+            }
+        }
+        const int checksumCount = mTurnCount / ChecksumInterval;
+        if (isSucceeded && checksumCount > 0) {
+            isSucceeded = std::fwrite(mChecksums, sizeof(uint), checksumCount, aFile) == static_cast<size_t>(checksumCount);
+        }
+        return isSucceeded && WriteValue(aFile, mEndChecksum);
+    }
+
+    //------------------------------------------------------------------------------
+    /// write で書き出した記録を読み込みます。
+    ///
+    /// @return 読み込みに成功した場合は @c true 。
+    bool ReplayStage::read(std::FILE* aFile)
+    {
+        bool isSucceeded = ReadValue(aFile, mStageIndex)
+            && ReadValue(aFile, mSystemSeed)
+            && ReadValue(aFile, mGameSeed)
+            && ReadValue(aFile, mTurnCount)
+            && 0 <= mStageIndex && mStageIndex < Parameter::GameStageCount
+            && 0 <= mTurnCount && mTurnCount <= Parameter::GameTurnPerStage;
+        for (int turn = 0; isSucceeded && turn < mTurnCount; ++turn) {
+            unsigned char type = 0;
+            isSucceeded = ReadValue(aFile, type);
+            if (!isSucceeded) {
+                break;
+            }
+            if (type == ActionType_Accel) {
+                Vec2 value;
+                isSucceeded = ReadValue(aFile, value.x) && ReadValue(aFile, value.y);
+                mActions[turn] = Action::Accel(value);
+            } else {
+                isSucceeded = type == ActionType_Wait;
+                mActions[turn] = Action::Wait();
+            }
+        }
+        const int checksumCount = mTurnCount / ChecksumInterval;
+        if (isSucceeded && checksumCount > 0) {
+            isSucceeded = std::fread(mChecksums, sizeof(uint), checksumCount, aFile) == static_cast<size_t>(checksumCount);
+        }
+        return isSucceeded && ReadValue(aFile, mEndChecksum);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 全キャラの位置・加速回数・通過した蓮の数からチェックサムを計算します。
+    ///
+    /// @param[in] aCharas キャラ情報。
+    ///
+    /// @return FNV-1a によるチェックサム。
+    uint ReplayStage::Checksum(const CharaCollection& aCharas)
+    {
+        uint hash = 2166136261u;
+        for (int index = 0; index < aCharas.count(); ++index) {
+            const Chara& chara = aCharas[index];
+            const Vec2 pos = chara.pos();
+            const int accelCount = chara.accelCount();
+            const int passedLotusCount = chara.passedLotusCount();
+            hash = AddChecksum(hash, &pos.x, sizeof(pos.x));
+            hash = AddChecksum(hash, &pos.y, sizeof(pos.y));
+            hash = AddChecksum(hash, &accelCount, sizeof(accelCount));
+            hash = AddChecksum(hash, &passedLotusCount, sizeof(passedLotusCount));
+        }
+        return hash;
+    }
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    Replay::Replay()
+        : mStages()
+        , mStageCount(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    ReplayStage& Replay::stage(int aStageIndex)
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        return mStages[aStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    const ReplayStage& Replay::stage(int aStageIndex)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        return mStages[aStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    int Replay::stageCount()const
+    {
+        return mStageCount;
+    }
+
+    //------------------------------------------------------------------------------
+    void Replay::setStageCount(int aCount)
+    {
+        HPC_RANGE_ASSERT_MIN_MAX_I(aCount, 0, Parameter::GameStageCount);
+        mStageCount = aCount;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 記録したステージをファイルに保存します。
+    ///
+    /// @param[in] aFileName ファイル名。
+    ///
+    /// @return 保存に成功した場合は @c true 。
+    bool Replay::save(const char* aFileName)const
+    {
+        std::FILE* file = std::fopen(aFileName, "wb");
+        if (!file) {
+            return false;
+        }
+        bool isSucceeded = std::fwrite(FileMagic, sizeof(FileMagic), 1, file) == 1
+            && WriteValue(file, FileVersion)
+            && WriteValue(file, mStageCount);
+        for (int index = 0; isSucceeded && index < mStageCount; ++index) {
+            isSucceeded = mStages[index].write(file);
+        }
+        return std::fclose(file) == 0 && isSucceeded;
+    }
+
+    //------------------------------------------------------------------------------
+    /// save で保存したファイルを読み込みます。
+    ///
+    /// @param[in] aFileName ファイル名。
+    ///
+    /// @return 読み込みに成功した場合は @c true 。失敗した場合、記録したステージ数は 0 になります。
+    bool Replay::load(const char* aFileName)
+    {
+        mStageCount = 0;
+        std::FILE* file = std::fopen(aFileName, "rb");
+        if (!file) {
+            return false;
+        }
+        char magic[sizeof(FileMagic)];
+        uint version = 0;
+        int stageCount = 0;
+        bool isSucceeded = std::fread(magic, sizeof(magic), 1, file) == 1
+            && std::memcmp(magic, FileMagic, sizeof(magic)) == 0
+            && ReadValue(file, version)
+            && version == FileVersion
+            && ReadValue(file, stageCount)
+            && 0 <= stageCount && stageCount <= Parameter::GameStageCount;
+        for (int index = 0; isSucceeded && index < stageCount; ++index) {
+            isSucceeded = mStages[index].read(file);
+        }
+        std::fclose(file);
+        if (isSucceeded) {
+            mStageCount = stageCount;
+        }
+        return isSucceeded;
+    }
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    Replayer::Replayer()
+        : mStage()
+        , mTurns()
+        , mTurnCount(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 記録された乱数の状態からステージを生成し、記録された動作でターンを進めて
+    /// 全ターンの結果を復元します。
+    ///
+    /// プレイヤーの動作は記録から与えるため、 Answer は呼び出されません。
+    ///
+    /// @param[in] aReplay 再シミュレーションするステージの記録。
+    ///
+    /// @return 全てのチェックサムが記録と一致した場合は @c true 。
+    bool Replayer::run(const ReplayStage& aReplay)
+    {
+        Random system = aReplay.systemRandom();
+        Random game = aReplay.gameRandom();
+        LevelDesigner::Setup(aReplay.stageIndex(), mStage, system);
+        mStage.setRecordLevel(RecordLevel_Full);
+
+        Brain::SetReplayActions(aReplay.actions(), aReplay.turnCount());
+        mStage.start();
+        mTurns[0].set(mStage.lastTurnResult());
+        mTurnCount = 1;
+
+        bool isMatched = true;
+        for (int turn = 1; turn <= aReplay.turnCount(); ++turn) {
+            if (mStage.lastTurnResult().state != StageState_Playing) {
+                isMatched = false;
+                break;
+            }
+            mStage.runTurn(game);
+            mTurns[mTurnCount++].set(mStage.lastTurnResult());
+            if (turn % ReplayStage::ChecksumInterval == 0
+                && ReplayStage::Checksum(mStage.charas()) != aReplay.checksum(turn)
+            ) {
+                isMatched = false;
+                break;
+            }
+        }
+        Brain::SetReplayActions(0, 0);
+
+        return isMatched && ReplayStage::Checksum(mStage.charas()) == aReplay.endChecksum();
+    }
+
+    //------------------------------------------------------------------------------
+    int Replayer::turnCount()const
+    {
+        return mTurnCount;
+    }
+
+    //------------------------------------------------------------------------------
+    const TurnResult& Replayer::turn(int aTurn)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aTurn, 0, mTurnCount);
+        return mTurns[aTurn];
+    }
+
+    //------------------------------------------------------------------------------
+    const Stage& Replayer::stage()const
+    {
+        return mStage;
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    ReplayStage, Replay, Replayer クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdio>
+#include "HPCAction.hpp"
+#include "HPCParameter.hpp"
+#include "HPCStage.hpp"
+#include "HPCTurnResult.hpp"
+#include "HPCTypes.hpp"
+
+namespace hpc {
+
+    class Random;
+
+    //------------------------------------------------------------------------------
+    /// @brief 1 ステージの実行を、再現に必要な最小限の情報で記録します。
+    ///
+    /// ステージの生成と CPU の動作は乱数の状態から決まるため、
+    /// ステージ開始時の乱数の状態とプレイヤーの動作だけを記録します。
+    /// 再現結果の検証用に、一定ターンごとに全キャラの状態のチェックサムを記録します。
+    class ReplayStage
+    {
+    public:
+        static const int ChecksumInterval = 64;             ///< チェックサムを記録する間隔 [ターン]
+        static const int ChecksumCountMax = Parameter::GameTurnPerStage / ChecksumInterval + 1; ///< チェックサムの最大数
+
+        ReplayStage();
+
+        /// @name 記録動作を行う関数
+        //@{
+        void writeStart(int aStageIndex, const Random& aSystem, const Random& aGame); ///< 記録を開始します。
+        void writeTurn(const Stage& aStage);                ///< 各ターンのプレイヤーの動作を記録します。
+        void writeEnd(const Stage& aStage);                 ///< 終了時のチェックサムを記録します。
+        //@}
+
+        /// @name 記録を読み出す関数
+        //@{
+        int stageIndex()const;                             ///< ステージ番号を返します。
+        Random systemRandom()const;                        ///< ステージ開始時のシステム用乱数を返します。
+        Random gameRandom()const;                          ///< ステージ開始時のゲーム用乱数を返します。
+        int turnCount()const;                              ///< 記録したターン数を返します。
+        const Action* actions()const;                      ///< 各ターンのプレイヤーの動作を返します。
+        uint checksum(int aTurn)const;                     ///< 指定ターン終了時のチェックサムを返します。
+        uint endChecksum()const;                           ///< 終了時のチェックサムを返します。
+        //@}
+
+        bool write(std::FILE* aFile)const;                 ///< ファイルに書き出します。
+        bool read(std::FILE* aFile);                        ///< ファイルから読み込みます。
+
+        static uint Checksum(const CharaCollection& aCharas); ///< 全キャラの状態のチェックサムを計算します。
+
+    private:
+        int mStageIndex;                                    ///< ステージ番号
+        uint mSystemSeed[2];                                ///< 開始時のシステム用乱数の状態
+        uint mGameSeed[2];                                  ///< 開始時のゲーム用乱数の状態
+        int mTurnCount;                                     ///< 記録したターン数
+        Action mActions[Parameter::GameTurnPerStage];       ///< 各ターンのプレイヤーの動作
+        uint mChecksums[ChecksumCountMax];                  ///< ChecksumInterval ターンごとのチェックサム
+        uint mEndChecksum;                                  ///< 終了時のチェックサム
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief ゲーム全体のリプレイを表します。
+    class Replay
+    {
+    public:
+        Replay();
+
+        ReplayStage& stage(int aStageIndex);                ///< ステージの記録を返します。
+        const ReplayStage& stage(int aStageIndex)const;    ///< ステージの記録を返します。
+        int stageCount()const;                             ///< 記録したステージ数を返します。
+        void setStageCount(int aCount);                     ///< 記録したステージ数を設定します。
+
+        bool save(const char* aFileName)const;             ///< ファイルに保存します。
+        bool load(const char* aFileName);                   ///< ファイルから読み込みます。
+
+    private:
+        ReplayStage mStages[Parameter::GameStageCount];    ///< ステージごとの記録
+        int mStageCount;                                    ///< 記録したステージ数
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief ReplayStage からステージを再シミュレーションし、全ターンの結果を復元します。
+    class Replayer
+    {
+    public:
+        Replayer();
+
+        bool run(const ReplayStage& aReplay);               ///< 再シミュレーションを行います。
+
+        int turnCount()const;                              ///< 復元したターン数 (初期状態を含む) を返します。
+        const TurnResult& turn(int aTurn)const;            ///< 復元したターンの結果を返します。
+        const Stage& stage()const;                         ///< 再シミュレーションしたステージを返します。
+
+    private:
+        Stage mStage;                                       ///< 再シミュレーションするステージ
+        TurnResult mTurns[Parameter::GameTurnPerStage + 1]; ///< 復元したターン。初期状態を含めるので1多くとる。
+        int mTurnCount;                                     ///< 復元したターン数
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -13,8 +13,14 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <ctime>
+#include "HPCCheckpoint.hpp"
 #include "HPCCommon.hpp"
 #include "HPCMath.hpp"
+#include "HPCRecordFile.hpp"
+#include "HPCReplay.hpp"
+#include "HPCStageScheduler.hpp"
+#include "HPCTimeBudget.hpp"
 #include "HPCTimer.hpp"
 
 namespace {
@@ -57,6 +63,9 @@ namespace {
         DebugCommand_Prev,          ///< 前へ
         DebugCommand_Jump,          ///< 指定番号のステージにジャンプ
         DebugCommand_Show,          ///< 再度
+        DebugCommand_Turn,          ///< 指定ターンに移動
+        DebugCommand_Step,          ///< 指定ターン数進む
+        DebugCommand_Back,          ///< 指定ターン数戻る
         DebugCommand_Help,          ///< ヘルプを表示
         DebugCommand_Exit,          ///< 終わる
 
@@ -125,6 +134,9 @@ namespace {
             case 'n': return DebugCommandSet(DebugCommand_Next, arg1, arg2);
             case 'p': return DebugCommandSet(DebugCommand_Prev, arg1, arg2);
             case 'd': return DebugCommandSet(DebugCommand_Show, arg1, arg2);
+            case 't': return DebugCommandSet(DebugCommand_Turn, arg1, arg2);
+            case 's': return DebugCommandSet(DebugCommand_Step, arg1, arg2);
+            case 'b': return DebugCommandSet(DebugCommand_Back, arg1, arg2);
             case 'j': return DebugCommandSet(DebugCommand_Jump, arg1, arg2);
             case 'h': return DebugCommandSet(DebugCommand_Help, arg1, arg2);
             case 'e': return DebugCommandSet(DebugCommand_Exit, arg1, arg2);
@@ -143,9 +155,107 @@ namespace {
         HPC_PRINT(" p           : Go to the prev stage.\n");
         HPC_PRINT(" j [stage=0] : Go to the designated stage.\n");
         HPC_PRINT(" d           : Show the result of this stage.\n");
+        HPC_PRINT(" t [turn=0]  : Go to the designated turn of this stage and show it.\n");
+        HPC_PRINT(" s [count=1] : Step forward and show the turn.\n");
+        HPC_PRINT(" b [count=1] : Step back and show the turn.\n");
         HPC_PRINT(" h           : Show Help.\n");
         HPC_PRINT(" e           : Exit debugger.\n");
     }
+
+    // new, delete を使うことは出来ないので、リプレイの検証に使うものも static に用意します。
+    hpc::Replay sLoadedReplay;      ///< ファイルから読み込んだリプレイ
+    hpc::Replayer sReplayers[hpc::StageScheduler::WorkerCountMax]; ///< ワーカーごとに再シミュレーションを行うクラス
+    hpc::StageScheduler sScheduler; ///< 再シミュレーションをワーカーに割り当てるクラス
+    hpc::RecordFile sRecordFile;    ///< 索引付きの JSON ファイル
+    hpc::TurnSeeker sTurnSeeker;    ///< デバッガでターン単位の移動を行うクラス
+    hpc::RecordStage sLoadedStage;  ///< ファイルから読み出したステージの記録
+    int sLoadedStageIndex = -1;     ///< sLoadedStage に読み出しているステージの番号
+
+    //------------------------------------------------------------------------------
+    /// @brief リプレイの各ステージを再シミュレーションし、記録と一致するかを調べます。
+    class ReplayVerifyTask : public hpc::StageTask
+    {
+    public:
+        explicit ReplayVerifyTask(const hpc::Replay& aReplay)
+            : mReplay(aReplay)
+            , mIsMatched()
+            , mTurnCounts()
+        {
+        }
+
+        virtual void runStage(int aStageIndex, int aWorkerIndex)
+        {
+            hpc::Replayer& replayer = sReplayers[aWorkerIndex];
+            mIsMatched[aStageIndex] = replayer.run(mReplay.stage(aStageIndex));
+            mTurnCounts[aStageIndex] = replayer.turnCount();
+        }
+
+        bool isMatched(int aStageIndex)const { return mIsMatched[aStageIndex]; }
+        int turnCount(int aStageIndex)const { return mTurnCounts[aStageIndex]; }
+
+    private:
+        const hpc::Replay& mReplay;                                 ///< 検証するリプレイ
+        bool mIsMatched[hpc::Parameter::GameStageCount];            ///< ステージごとの検証結果
+        int mTurnCounts[hpc::Parameter::GameStageCount];            ///< ステージごとの復元したターン数
+    };
+
+    //------------------------------------------------------------------------------
+    /// ファイルからステージの記録を読み出して表示します。
+    /// 直前に読み出したステージであれば、読み出し直しません。
+    void DumpFileStage(const hpc::RecordFile& aFile, int aStageIndex)
+    {
+        if (aStageIndex != sLoadedStageIndex) {
+            sLoadedStageIndex = -1;
+            if (!aFile.loadStage(aStageIndex, sLoadedStage)) {
+                HPC_PRINT("Index: cannot decode stage %d.\n", aStageIndex);
+                return;
+            }
+            sLoadedStageIndex = aStageIndex;
+        }
+        HPC_PRINT_LOG("Stage", "%d\n", aStageIndex);
+        sLoadedStage.dump();
+    }
+
+    //------------------------------------------------------------------------------
+    /// ターン単位で移動し、そのターンの状態を表示します。
+    ///
+    /// @param[in] aCheckpoints 保存した状態。
+    /// @param[in] aReplay      ステージのリプレイ。
+    /// @param[in] aTurn        移動するターン。
+    ///
+    /// @return 移動したターン。移動できなかった場合は aTurn 。
+    int SeekAndShowTurn(const hpc::CheckpointStore& aCheckpoints, const hpc::ReplayStage& aReplay, int aTurn)
+    {
+        if (!sTurnSeeker.seek(aCheckpoints, aReplay, aTurn)) {
+            HPC_PRINT("Turn: no checkpoint for stage %d.\n", aReplay.stageIndex());
+            return aTurn;
+        }
+        const hpc::Stage& stage = sTurnSeeker.stage();
+        static const char StateChars[hpc::StageState_TERM] = { ' ', 'C', 'F', 'L' };
+        HPC_PRINT_LOG("Turn", "#%04d: %c\n", sTurnSeeker.turn(), StateChars[stage.lastTurnResult().state]);
+        for (int charaIndex = 0; charaIndex < stage.charas().count(); ++charaIndex) {
+            const hpc::Chara& chara = stage.charas()[charaIndex];
+            HPC_PRINT(
+                " chara[%d] - [%7.2f,%7.2f] vel(%6.3f,%6.3f) accel %d lotus %3d rank %d\n"
+                , charaIndex
+                , chara.pos().x
+                , chara.pos().y
+                , chara.vel().x
+                , chara.vel().y
+                , chara.accelCount()
+                , chara.passedLotusCount()
+                , chara.rank()
+                );
+        }
+        HPC_PRINT_LOG(
+            "Seek", "resimulated %d turns (checkpoint every %d turns, %d stored, %d KB)\n"
+            , sTurnSeeker.resimulatedTurnCount()
+            , aCheckpoints.interval()
+            , aCheckpoints.count()
+            , aCheckpoints.byteSize() / 1024
+            );
+        return sTurnSeeker.turn();
+    }
 }
 
 namespace hpc {
@@ -156,7 +266,74 @@ namespace hpc {
         : mRandSet()
         , mGame(mRandSet)
         , mTimer(Parameter::GameTimeLimitSec)
+        , mRecordStream()
+        , mStreamFile(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// @brief 記録レベルを設定します。 run の前に呼び出します。
+    ///
+    /// 既定では RecordLevel_Full です。
+    /// 得点しか使わない場合は RecordLevel_Score にすることで、ターンごとの記録を省略できます。
+    ///
+    /// @param[in] aLevel 記録レベル。
+    void Simulation::setRecordLevel(RecordLevel aLevel)
+    {
+        mGame.setRecordLevel(aLevel);
+    }
+
+    //------------------------------------------------------------------------------
+    /// @brief リプレイを記録するかを設定します。 run の前に呼び出します。
+    ///
+    /// 既定では記録しません。リプレイの出力とデバッガのターン単位の移動に必要です。
+    ///
+    /// @param[in] aIsEnabled 記録する場合は @c true 。
+    void Simulation::setReplayEnabled(bool aIsEnabled)
+    {
+        mGame.setReplayEnabled(aIsEnabled);
+    }
+
+    //------------------------------------------------------------------------------
+    /// @brief デバッガでターン単位の移動に使う、ステージの状態を保存する間隔を設定します。 run の前に呼び出します。
+    ///
+    /// 間隔を短くするとメモリを多く使い、移動に掛かる再シミュレーションが短くなります。
+    ///
+    /// @param[in] aInterval 保存間隔 [ターン] 。 0 の場合は保存せず、ターン単位の移動もできません。
+    void Simulation::setCheckpointInterval(int aInterval)
+    {
+        mGame.setCheckpointInterval(aInterval);
+    }
+
+    //------------------------------------------------------------------------------
+    /// @brief JSON の出力を、シミュレーションと並行して行うようにします。 run の前に呼び出します。
+    ///
+    /// 終わったステージの記録は、次のステージを実行している間に別スレッドで出力されます。
+    /// 残りの出力は outputJson または outputJsonLines で待ちます。
+    ///
+    /// @param[in] aFormat 出力形式。 JsonFormat_Indexed は startIndexedJsonStream を使います。
+    void Simulation::startJsonStream(JsonFormat aFormat)
+    {
+        HPC_ASSERT(aFormat != JsonFormat_Indexed);
+        mRecordStream.start(mGame.record(), stdout, aFormat);
+    }
+
+    //------------------------------------------------------------------------------
+    /// @brief 索引付きの圧縮された JSON を、シミュレーションと並行してファイルに出力するようにします。
+    /// run の前に呼び出します。残りの出力は outputIndexedJson で待ちます。
+    ///
+    /// @param[in] aFileName 出力先のファイル名。
+    ///
+    /// @return ファイルを開けた場合は @c true 。
+    bool Simulation::startIndexedJsonStream(const char* aFileName)
     {
+        mStreamFile = std::fopen(aFileName, "wb");
+        if (!mStreamFile) {
+            HPC_PRINT("Index: cannot write %s.\n", aFileName);
+            return false;
+        }
+        mRecordStream.start(mGame.record(), mStreamFile, JsonFormat_Indexed);
+        return true;
     }
 
     //------------------------------------------------------------------------------
@@ -164,13 +341,22 @@ namespace hpc {
     void Simulation::run()
     {
         // 制限時間と制限ターン数
+        // 制限時間はステージごとに割り当て、解答プログラムに目安として示す。
+        TimeBudget& timeBudget = TimeBudget::Current();
         mTimer.start();
+        timeBudget.start(mTimer);
         while (mGame.isValidStage()) {
+            timeBudget.startStage(mGame.stageIndex());
             mGame.startStage();
             while (mGame.state() == StageState_Playing && mTimer.isInTime()) {
                 mGame.runTurn();
             }
+            const int stageIndex = mGame.stageIndex();
             mGame.onStageDone();
+            timeBudget.endStage();
+            if (mRecordStream.isRunning()) {
+                mRecordStream.notifyStageDone(stageIndex);
+            }
         }
     }
 
@@ -191,7 +377,7 @@ namespace hpc {
         // 入力待ち
         switch (SelectInput()) {
         case Command_Debug:
-            runDebugger();
+            runDebugger(0);
             break;
 
         case Command_OutputJson:
@@ -207,18 +393,183 @@ namespace hpc {
         }
     }
 
+    //------------------------------------------------------------------------------
+    /// @brief 以前に出力した JSON ファイルを読み込み、デバッグします。
+    ///
+    /// ゲームは実行しません。ファイルはメモリにマップし、ステージは表示するときに読み出します。
+    ///
+    /// @param[in] aFileName -x, -j, -jd で出力したファイルの名前。
+    void Simulation::debugFile(const char* aFileName)
+    {
+        if (!sRecordFile.open(aFileName)) {
+            HPC_PRINT("Index: cannot read %s.\n", aFileName);
+            return;
+        }
+        HPC_PRINT("%8s:%8d stages (%s)\n", "Loaded", sRecordFile.stageCount(), aFileName);
+        sLoadedStageIndex = -1;
+        runDebugger(&sRecordFile);
+        sRecordFile.close();
+    }
+
     //------------------------------------------------------------------------------
     /// JSON データを出力します。
-    void Simulation::outputJson(bool isCompressed)const
+    /// startJsonStream で出力を始めている場合は、その出力が終わるのを待ちます。
+    void Simulation::outputJson(bool isCompressed)
     {
+        if (mRecordStream.isRunning()) {
+            mRecordStream.finish();
+            return;
+        }
         mGame.record().dumpJson(isCompressed);
     }
 
+    //------------------------------------------------------------------------------
+    /// JSON Lines 形式でデータを出力します。
+    /// startJsonStream で出力を始めている場合は、その出力が終わるのを待ちます。
+    void Simulation::outputJsonLines()
+    {
+        if (mRecordStream.isRunning()) {
+            mRecordStream.finish();
+            return;
+        }
+        mGame.record().dumpJsonLines();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 解答プログラムの探索に関する統計情報を、ステージごとに表示します。
+    void Simulation::outputSolverStats()const
+    {
+        mGame.record().dumpSolverStats();
+        TimeBudget::Current().dump();
+    }
+
+    //------------------------------------------------------------------------------
+    /// リプレイをファイルに保存します。
+    /// 保存したファイルを読み込み直して全ステージを再シミュレーションし、
+    /// 記録したチェックサムと一致するかを表示します。
+    /// 再シミュレーションはステージごとに独立しているので、 StageScheduler で複数のスレッドに分担します。
+    ///
+    /// @param[in] aFileName 保存先のファイル名。
+    void Simulation::outputReplay(const char* aFileName)const
+    {
+        if (!mGame.replay().save(aFileName)) {
+            HPC_PRINT("Replay: cannot write %s.\n", aFileName);
+            return;
+        }
+        if (!sLoadedReplay.load(aFileName)) {
+            HPC_PRINT("Replay: cannot read %s.\n", aFileName);
+            return;
+        }
+        ReplayVerifyTask task(sLoadedReplay);
+        sScheduler.run(task, sLoadedReplay.stageCount(), hpc::StageScheduler::DefaultWorkerCount());
+        int verifiedCount = 0;
+        int turnCount = 0;
+        for (int index = 0; index < sLoadedReplay.stageCount(); ++index) {
+            if (task.isMatched(index)) {
+                ++verifiedCount;
+            } else {
+                HPC_PRINT("Replay: stage %d does not match.\n", index);
+            }
+            turnCount += task.turnCount(index);
+        }
+        long size = 0;
+        if (std::FILE* file = std::fopen(aFileName, "rb")) {
+            std::fseek(file, 0, SEEK_END);
+            size = std::ftell(file);
+            std::fclose(file);
+        }
+        HPC_PRINT("%8s:%8ld bytes (%s)\n", "Replay", size, aFileName);
+        HPC_PRINT("%8s:%5d / %d stages, %d turns\n", "Verified", verifiedCount, sLoadedReplay.stageCount(), turnCount);
+        HPC_PRINT("%8s:%5d workers, %d steals, makespan %.3f s, work %.3f s\n"
+            , "Schedule"
+            , sScheduler.workerCount()
+            , sScheduler.stealCount()
+            , sScheduler.makespanSec()
+            , sScheduler.workSec()
+            );
+    }
+
+    //------------------------------------------------------------------------------
+    /// ビューア用のバイナリ形式で全ステージの結果を保存し、ファイルの大きさを表示します。
+    ///
+    /// @param[in] aFileName 保存先のファイル名。
+    void Simulation::outputBinary(const char* aFileName)const
+    {
+        if (!mGame.record().saveBinary(aFileName)) {
+            HPC_PRINT("Binary: cannot write %s.\n", aFileName);
+            return;
+        }
+        long size = 0;
+        if (std::FILE* file = std::fopen(aFileName, "rb")) {
+            std::fseek(file, 0, SEEK_END);
+            size = std::ftell(file);
+            std::fclose(file);
+        }
+        HPC_PRINT("%8s:%8ld bytes (%s)\n", "Binary", size, aFileName);
+    }
+
+    //------------------------------------------------------------------------------
+    /// startIndexedJsonStream で始めた出力を書き終えます。
+    /// 書き終えたファイルを開き直し、索引を使って全ステージを 1 つずつ読み出して、
+    /// 得点が一致するかと読み出しに掛かった時間を表示します。
+    ///
+    /// @param[in] aFileName 出力先のファイル名。
+    void Simulation::outputIndexedJson(const char* aFileName)
+    {
+        if (!mStreamFile) {
+            return;
+        }
+        mRecordStream.finish();
+        std::fclose(mStreamFile);
+        mStreamFile = 0;
+
+        if (!sRecordFile.open(aFileName)) {
+            HPC_PRINT("Index: cannot read %s.\n", aFileName);
+            return;
+        }
+        sLoadedStageIndex = -1;
+        int verifiedCount = 0;
+        double maxSec = 0.0;
+        const std::clock_t timeBegin = std::clock();
+        // 後ろのステージから読み、先頭から順に解釈していないことを確かめる。
+        for (int index = sRecordFile.stageCount() - 1; 0 <= index; --index) {
+            const std::clock_t stageBegin = std::clock();
+            const bool isLoaded = sRecordFile.loadStage(index, sLoadedStage);
+            const double stageSec = static_cast<double>(std::clock() - stageBegin) / CLOCKS_PER_SEC;
+            if (maxSec < stageSec) {
+                maxSec = stageSec;
+            }
+            if (
+                isLoaded
+                && static_cast<int>(sLoadedStage.score()) == sRecordFile.entry(index).score
+                && sLoadedStage.recordedTurnCount() == sRecordFile.entry(index).turnCount
+            ) {
+                ++verifiedCount;
+            } else {
+                HPC_PRINT("Index: stage %d does not match.\n", index);
+            }
+        }
+        const double totalSec = static_cast<double>(std::clock() - timeBegin) / CLOCKS_PER_SEC;
+        HPC_PRINT("%8s:%8d bytes (%s)\n", "Index", sRecordFile.fileSize(), aFileName);
+        HPC_PRINT("%8s:%5d / %d stages\n", "Verified", verifiedCount, sRecordFile.stageCount());
+        HPC_PRINT(
+            "%8s:%8.3f ms/stage (max %.3f ms)\n"
+            , "Load"
+            , sRecordFile.stageCount() > 0 ? totalSec * 1000.0 / sRecordFile.stageCount() : 0.0
+            , maxSec * 1000.0
+            );
+        sRecordFile.close();
+    }
+
     //------------------------------------------------------------------------------
     /// デバッグ実行を行います。
-    void Simulation::runDebugger()
+    ///
+    /// @param[in] aFile 記録を読み出すファイル。 0 の場合は実行したゲームの記録を使います。
+    void Simulation::runDebugger(const RecordFile* aFile)
     {
+        const int stageCount = aFile ? aFile->stageCount() : Parameter::GameStageCount;
         int stage = 0;
+        int turn = 0;
         bool doInput = true;    // ステージ終了時に入力待ち　するか。
         do {
             if (doInput) {
@@ -226,18 +577,45 @@ namespace hpc {
                 switch(commandSet.command) {
                 case DebugCommand_Next:
                     ++stage;
+                    turn = 0;
                     break;
 
                 case DebugCommand_Prev:
                     stage = Math::Max(stage - 1, 0);
+                    turn = 0;
                     break;
 
                 case DebugCommand_Show:
-                    mGame.record().dumpStage(stage);
+                    if (aFile) {
+                        DumpFileStage(*aFile, stage);
+                    } else {
+                        mGame.record().dumpStage(stage);
+                    }
                     break;
 
                 case DebugCommand_Jump:
-                    stage = Math::LimitMinMax(commandSet.arg1, 0, Parameter::GameStageCount - 1);
+                    stage = Math::LimitMinMax(commandSet.arg1, 0, stageCount - 1);
+                    turn = 0;
+                    break;
+
+                case DebugCommand_Turn:
+                case DebugCommand_Step:
+                case DebugCommand_Back:
+                    // ファイルにはリプレイが無いので、ターン単位の移動はできない。
+                    if (aFile) {
+                        HPC_PRINT("Turn: not available for a loaded file.\n");
+                        break;
+                    }
+                    {
+                        const int count = commandSet.arg1 > 0 ? commandSet.arg1 : 1;
+                        int target = commandSet.arg1;
+                        if (commandSet.command == DebugCommand_Step) {
+                            target = turn + count;
+                        } else if (commandSet.command == DebugCommand_Back) {
+                            target = turn - count;
+                        }
+                        turn = SeekAndShowTurn(mGame.checkpoints(), mGame.replay().stage(stage), target);
+                    }
                     break;
 
                 case DebugCommand_Help:
@@ -245,7 +623,7 @@ namespace hpc {
                     break;
 
                 case DebugCommand_Exit:
-                    stage = Parameter::GameStageCount;
+                    stage = stageCount;
                     break;
 
                 default:
@@ -256,7 +634,7 @@ namespace hpc {
             else {
                 ++stage;
             }
-        } while (stage < Parameter::GameStageCount);
+        } while (stage < stageCount);
     }
 }
 
@@ -10,8 +10,11 @@
 //------------------------------------------------------------------------------
 #pragma once
 
+#include <cstdio>
 #include "HPCGame.hpp"
 #include "HPCRandomSet.hpp"
+#include "HPCRecordFile.hpp"
+#include "HPCRecordStream.hpp"
 #include "HPCTimer.hpp"
 
 namespace hpc {
@@ -23,17 +26,30 @@ namespace hpc {
     public:
         Simulation();
 
+        void setRecordLevel(RecordLevel aLevel);       ///< 記録レベルを設定する
+        void setReplayEnabled(bool aIsEnabled);        ///< リプレイを記録するかを設定する
+        void setCheckpointInterval(int aInterval);     ///< デバッガ用に状態を保存する間隔を設定する
+        void startJsonStream(JsonFormat aFormat);      ///< JSON をステージごとに並行して出力する
+        bool startIndexedJsonStream(const char* aFileName); ///< 索引付きの JSON をファイルに並行して出力する
         void run();                                    ///< 開始する
         void debug();                                  ///< デバッグする
+        void debugFile(const char* aFileName);         ///< 記録ファイルを読み込んでデバッグする
         void outputResult()const;                     ///< 結果を表示する。
-        void outputJson(bool isCompressed)const;      ///< JSON の出力を行う。
+        void outputJson(bool isCompressed);           ///< JSON の出力を行う。
+        void outputJsonLines();                        ///< JSON Lines の出力を行う。
+        void outputSolverStats()const;                ///< 探索の統計情報を表示する。
+        void outputReplay(const char* aFileName)const;///< リプレイを保存し、再シミュレーションで検証する。
+        void outputBinary(const char* aFileName)const;///< ビューア用のバイナリ形式で結果を保存する。
+        void outputIndexedJson(const char* aFileName); ///< 索引付きの JSON を書き終え、ステージ単位の読み出しを検証する。
         
     private:
         RandomSet mRandSet; ///< 乱数生成クラス
         Game mGame;         ///< シミュレーションするゲーム
         Timer mTimer;       ///< ゲームタイマー
+        RecordStream mRecordStream; ///< JSON の並行出力
+        std::FILE* mStreamFile;     ///< JSON の出力先のファイル
 
-        void runDebugger();
+        void runDebugger(const RecordFile* aFile);
     };
 }
 //------------------------------------------------------------------------------
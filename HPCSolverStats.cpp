@@ -0,0 +1,250 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCSolverStats.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCSolverStats.hpp"
+
+#include "HPCCommon.hpp"
+#include "HPCMath.hpp"
+
+namespace {
+
+    //------------------------------------------------------------------------------
+    /// std::clock_t で表される時間を秒に変換します。
+    double ToSec(std::clock_t aTime)
+    {
+        return static_cast<double>(aTime) / CLOCKS_PER_SEC;
+    }
+}
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    SolverStats::SolverStats()
+        : mReplanCounts()
+        , mSegmentHitCount(0)
+        , mSearchCount(0)
+        , mExpandedCells(0)
+        , mMaxDepth(0)
+        , mDepthSum(0)
+        , mSearchClock(0)
+        , mMaxSearchClock(0)
+        , mSearchBegin(0)
+        , mDeviationCount(0)
+        , mDeviationSum(0)
+        , mDeviationMax(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 全ての値を初期状態に戻します。
+    void SolverStats::reset()
+    {
+        *this = SolverStats();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 別のステージの統計情報を加算します。
+    /// 最大値を表す値は、大きい方が残ります。
+    ///
+    /// @param[in] aStats 加算する統計情報。
+    void SolverStats::add(const SolverStats& aStats)
+    {
+        for (int reason = 0; reason < ReplanReason_TERM; ++reason) {
+            mReplanCounts[reason] += aStats.mReplanCounts[reason];
+        }
+        mSegmentHitCount += aStats.mSegmentHitCount;
+        mSearchCount += aStats.mSearchCount;
+        mExpandedCells += aStats.mExpandedCells;
+        mMaxDepth = Math::Max(mMaxDepth, aStats.mMaxDepth);
+        mDepthSum += aStats.mDepthSum;
+        mSearchClock += aStats.mSearchClock;
+        mMaxSearchClock = mMaxSearchClock < aStats.mMaxSearchClock ? aStats.mMaxSearchClock : mMaxSearchClock;
+        mDeviationCount += aStats.mDeviationCount;
+        mDeviationSum += aStats.mDeviationSum;
+        mDeviationMax = Math::Max(mDeviationMax, aStats.mDeviationMax);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 予測した位置と実際の位置のずれを記録します。
+    ///
+    /// @param[in] aDist 予測した位置と実際の位置の距離。
+    void SolverStats::writeDeviation(float aDist)
+    {
+        ++mDeviationCount;
+        mDeviationSum += aDist;
+        mDeviationMax = Math::Max(mDeviationMax, aDist);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 再探索を行ったことを記録します。
+    ///
+    /// @param[in] aReason 再探索の理由。
+    void SolverStats::writeReplan(ReplanReason aReason)
+    {
+        HPC_ENUM_ASSERT(ReplanReason, aReason);
+        ++mReplanCounts[aReason];
+    }
+
+    //------------------------------------------------------------------------------
+    /// 前の周の行動列を再利用できたことを記録します。
+    /// 再利用した場合は探索を行わないので、再探索の回数には含めません。
+    void SolverStats::writeSegmentHit()
+    {
+        ++mSegmentHitCount;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 探索の開始時刻を記録します。
+    /// 探索の終了時には endSearch を呼び出します。
+    void SolverStats::beginSearch()
+    {
+        mSearchBegin = std::clock();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 探索の終了を記録します。
+    ///
+    /// @param[in] aDepth    探索で到達したターン数。
+    /// @param[in] aExpanded 探索で展開したセル数。
+    void SolverStats::endSearch(int aDepth, int aExpanded)
+    {
+        const std::clock_t clock = std::clock() - mSearchBegin;
+        ++mSearchCount;
+        mExpandedCells += aExpanded;
+        mMaxDepth = Math::Max(mMaxDepth, aDepth);
+        mDepthSum += aDepth;
+        mSearchClock += clock;
+        mMaxSearchClock = mMaxSearchClock < clock ? clock : mMaxSearchClock;
+    }
+
+    //------------------------------------------------------------------------------
+    int SolverStats::replanCount()const
+    {
+        int count = 0;
+        for (int reason = 0; reason < ReplanReason_TERM; ++reason) {
+            count += mReplanCounts[reason];
+        }
+        return count;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aReason 再探索の理由。
+    int SolverStats::replanCount(ReplanReason aReason)const
+    {
+        HPC_ENUM_ASSERT(ReplanReason, aReason);
+        return mReplanCounts[aReason];
+    }
+
+    //------------------------------------------------------------------------------
+    int SolverStats::segmentHitCount()const
+    {
+        return mSegmentHitCount;
+    }
+
+    //------------------------------------------------------------------------------
+    int SolverStats::searchCount()const
+    {
+        return mSearchCount;
+    }
+
+    //------------------------------------------------------------------------------
+    long long SolverStats::expandedCells()const
+    {
+        return mExpandedCells;
+    }
+
+    //------------------------------------------------------------------------------
+    int SolverStats::maxDepth()const
+    {
+        return mMaxDepth;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 探索を行っていない場合は 0 を返します。
+    double SolverStats::averageDepth()const
+    {
+        return mSearchCount ? static_cast<double>(mDepthSum) / mSearchCount : 0.0;
+    }
+
+    //------------------------------------------------------------------------------
+    double SolverStats::searchSec()const
+    {
+        return ToSec(mSearchClock);
+    }
+
+    //------------------------------------------------------------------------------
+    double SolverStats::maxSearchSec()const
+    {
+        return ToSec(mMaxSearchClock);
+    }
+
+    //------------------------------------------------------------------------------
+    int SolverStats::deviationCount()const
+    {
+        return mDeviationCount;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 予測からずれていない場合は 0 を返します。
+    double SolverStats::averageDeviation()const
+    {
+        return mDeviationCount ? mDeviationSum / mDeviationCount : 0.0;
+    }
+
+    //------------------------------------------------------------------------------
+    float SolverStats::maxDeviation()const
+    {
+        return mDeviationMax;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 統計情報を画面に出力します。
+    void SolverStats::dump()const
+    {
+        HPC_PRINT_LOG(
+            "Replan", "%d (initial %d, threshold %d, deviation %d, segment %d)\n"
+            , replanCount()
+            , mReplanCounts[ReplanReason_Initial]
+            , mReplanCounts[ReplanReason_Threshold]
+            , mReplanCounts[ReplanReason_Deviation]
+            , mReplanCounts[ReplanReason_Segment]
+            );
+        HPC_PRINT_LOG("Segment", "%d hits\n", mSegmentHitCount);
+        HPC_PRINT_LOG(
+            "Search", "%d (depth avg %.1f max %d, time %.4f max %.4f)\n"
+            , mSearchCount
+            , averageDepth()
+            , mMaxDepth
+            , searchSec()
+            , maxSearchSec()
+            );
+        HPC_PRINT_LOG("Cells", "expanded %lld\n", mExpandedCells);
+        HPC_PRINT_LOG(
+            "Deviate", "%d (avg %.4f max %.4f)\n"
+            , mDeviationCount
+            , averageDeviation()
+            , mDeviationMax
+            );
+    }
+
+    //------------------------------------------------------------------------------
+    /// 実行中のステージの統計情報を取得します。
+    ///
+    /// @return ステージごとにリセットされる統計情報への参照。
+    SolverStats& SolverStats::Current()
+    {
+        static SolverStats sStats;
+        return sStats;
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    SolverStats クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <ctime>
+#include "HPCReplanReason.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief 解答プログラムの探索に関する統計情報を表します。
+    ///
+    /// ステージごとに Game がリセットし、終了時に Record へ記録されます。
+    /// 解答プログラムは Current() を通じて値を書き込みます。
+    class SolverStats
+    {
+    public:
+        SolverStats();
+
+        /// @name 記録動作を行う関数
+        //@{
+        void reset();                                       ///< 全ての値を初期化します。
+        void add(const SolverStats& aStats);                ///< 別の統計情報を加算します。
+        void writeDeviation(float aDist);                   ///< 予測位置からのずれを記録します。
+        void writeReplan(ReplanReason aReason);             ///< 再探索を記録します。
+        void writeSegmentHit();                             ///< 再利用できる行動列が見つかったことを記録します。
+        void beginSearch();                                 ///< 探索の開始を記録します。
+        void endSearch(int aDepth, int aExpanded);          ///< 探索の終了を記録します。
+        //@}
+
+        /// @name 記録を読み出す関数
+        //@{
+        int replanCount()const;                            ///< 再探索の回数を返します。
+        int replanCount(ReplanReason aReason)const;        ///< 指定した理由による再探索の回数を返します。
+        int segmentHitCount()const;                        ///< 行動列を再利用した回数を返します。
+        int searchCount()const;                            ///< 探索の回数を返します。
+        long long expandedCells()const;                    ///< 展開したセル数を返します。
+        int maxDepth()const;                               ///< 探索で到達した最大ターン数を返します。
+        double averageDepth()const;                        ///< 探索で到達した平均ターン数を返します。
+        double searchSec()const;                           ///< 探索に掛かった合計時間を返します。
+        double maxSearchSec()const;                        ///< 1 回の探索に掛かった最大時間を返します。
+        int deviationCount()const;                         ///< 予測からずれた回数を返します。
+        double averageDeviation()const;                    ///< 予測からのずれの平均を返します。
+        float maxDeviation()const;                         ///< 予測からのずれの最大値を返します。
+        //@}
+
+        void dump()const;                                  ///< 統計情報を画面に表示します。
+
+        static SolverStats& Current();                      ///< 実行中のステージの統計情報を取得します。
+
+    private:
+        int mReplanCounts[ReplanReason_TERM];               ///< 理由ごとの再探索の回数
+        int mSegmentHitCount;                               ///< 行動列を再利用した回数
+        int mSearchCount;                                   ///< 探索の回数
+        long long mExpandedCells;                           ///< 展開したセル数
+        int mMaxDepth;                                      ///< 最大到達ターン数
+        long long mDepthSum;                                ///< 到達ターン数の合計
+        std::clock_t mSearchClock;                          ///< 探索に掛かった合計時間
+        std::clock_t mMaxSearchClock;                       ///< 1 回の探索に掛かった最大時間
+        std::clock_t mSearchBegin;                          ///< 実行中の探索の開始時刻
+        int mDeviationCount;                                ///< 予測からずれた回数
+        double mDeviationSum;                               ///< 予測からのずれの合計
+        float mDeviationMax;                                ///< 予測からのずれの最大値
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -14,6 +14,7 @@
 #include "HPCCommon.hpp"
 #include "HPCLevelDesigner.hpp"
 #include "HPCParameter.hpp"
+#include "HPCTracer.hpp"
 
 namespace hpc {
 
@@ -25,6 +26,7 @@ namespace hpc {
         , mField()
         , mTurnResult()
         , mTurnIndex(0)
+        , mRecordLevel(RecordLevel_Full)
     {
     }
 
@@ -39,6 +41,32 @@ namespace hpc {
         mTurnIndex = 0;
     }
 
+    //------------------------------------------------------------------------------
+    /// TurnResult にどこまで記録するかを設定します。
+    ///
+    /// RecordLevel_Full 未満の場合、 TurnResult のキャラ情報は更新されず、
+    /// 状態 (state) のみが有効になります。
+    ///
+    /// @param[in] aLevel 記録レベル。
+    void Stage::setRecordLevel(RecordLevel aLevel)
+    {
+        HPC_ENUM_ASSERT(RecordLevel, aLevel);
+        mRecordLevel = aLevel;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 実行中の状態も含めてステージを複製します。
+    /// キャラが参照するステージは、複製元ではなくこのステージになります。
+    ///
+    /// @param[in] aStage 複製元のステージ。
+    void Stage::set(const Stage& aStage)
+    {
+        *this = aStage;
+        for (int index = 0; index < mCharas.count(); ++index) {
+            mCharas[index].bindStage(*this, index);
+        }
+    }
+
     //------------------------------------------------------------------------------
     /// ステージ開始時に一度だけ呼ぶことで、ステージの初期化処理を行います。
     ///
@@ -74,22 +102,34 @@ namespace hpc {
     void Stage::runTurn(Random& aRandom)
     {
         HPC_ASSERT(mTurnResult.state == StageState_Playing);
-        mTurnResult.reset();
+        if (mRecordLevel == RecordLevel_Full) {
+            mTurnResult.reset();
+        }
         
         // 各キャラの動作を確定する
+        Tracer::Begin("DecideAction");
         mCharas.procDecideAction(aRandom);
+        Tracer::End("DecideAction");
         
         // 動作が確定したら、動作を実行する
+        Tracer::Begin("ExecAction");
         mCharas.procExecAction();
+        Tracer::End("ExecAction");
         
         // 動作が実行されたら、キャラ同士の衝突判定を行う
+        Tracer::Begin("CheckColl");
         mCharas.procCheckColl();
+        Tracer::End("CheckColl");
         
         // 衝突判定が終わったら、最終処理を行う
+        Tracer::Begin("End");
         mCharas.procEnd(*this);
+        Tracer::End("End");
         
         // 結果の保存
+        Tracer::Begin("UpdateTurnResult");
         updateTurnResult();
+        Tracer::End("UpdateTurnResult");
         
         mTurnResult.state = StageState_Playing;
         
@@ -153,6 +193,10 @@ namespace hpc {
     /// キャラの情報を更新します。
     void Stage::updateTurnResult()
     {
+        // 得点だけを記録する場合は、キャラ情報は参照されない。
+        if (mRecordLevel != RecordLevel_Full) {
+            return;
+        }
         for (int index = 0; index < mCharas.count(); ++index) {
             mTurnResult.charas[index].pos = mCharas[index].pos();
             mTurnResult.charas[index].accelCount = mCharas[index].accelCount();
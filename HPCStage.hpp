@@ -13,6 +13,7 @@
 #include "HPCCharaCollection.hpp"
 #include "HPCField.hpp"
 #include "HPCLotusCollection.hpp"
+#include "HPCRecordLevel.hpp"
 #include "HPCTurnResult.hpp"
 
 namespace hpc {
@@ -25,6 +26,8 @@ namespace hpc {
         Stage();
 
         void reset();                                   ///< ステージ情報を削除します。
+        void set(const Stage& aStage);                  ///< 実行中の状態も含めてステージを複製します。
+        void setRecordLevel(RecordLevel aLevel);        ///< TurnResult に記録する情報の量を設定します。
 
         ///@name ステージの実行
         //@{
@@ -49,6 +52,7 @@ namespace hpc {
         Field mField;                   ///< フィールド情報
         TurnResult mTurnResult;         ///< ターンの実行結果
         int mTurnIndex;                 ///< 現在のターン番号
+        RecordLevel mRecordLevel;       ///< TurnResult に記録する情報の量
 
         void updateTurnResult();    ///< TurnResultを更新します。
     };
@@ -71,6 +71,16 @@ namespace hpc {
     {
         return mStagePtr->field();
     }
+
+    //------------------------------------------------------------------------------
+    /// 実行中のステージとターンに使ってよい時間を知るために使います。
+    /// 割り当てはゲーム全体で 1 つなので、どのキャラからも同じものが返ります。
+    ///
+    /// @return 実行時間の割り当て。
+    const TimeBudget& StageAccessor::timeBudget()const
+    {
+        return TimeBudget::Current();
+    }
 }
 //------------------------------------------------------------------------------
 // EOF
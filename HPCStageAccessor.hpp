@@ -13,6 +13,7 @@
 #include "HPCEnemyAccessor.hpp"
 #include "HPCField.hpp"
 #include "HPCLotusCollection.hpp"
+#include "HPCTimeBudget.hpp"
 
 namespace hpc {
 
@@ -38,6 +39,7 @@ namespace hpc {
         const EnemyAccessor& enemies()const;        ///< 敵キャラ情報を返します。
         const LotusCollection& lotuses()const;      ///< 蓮情報を返します。
         const Field& field()const;                  ///< フィールド情報を返します。
+        const TimeBudget& timeBudget()const;        ///< 実行時間の割り当てを返します。
         //@}
 
     private:
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCStagePipeline.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCStagePipeline.hpp"
+
+#include <chrono>
+#include "HPCCommon.hpp"
+#include "HPCLevelDesigner.hpp"
+#include "HPCParameter.hpp"
+#include "HPCTracer.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    StagePipeline::StagePipeline()
+        : mSystem(0)
+        , mBuffers()
+        , mThread()
+        , mGenerated(0)
+        , mTaken(0)
+        , mIsCancelled(false)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 生成スレッドが動いている場合、打ち切ってから破棄します。
+    StagePipeline::~StagePipeline()
+    {
+        cancel();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 生成するステージの記録レベルを設定します。生成スレッドを開始する前に呼び出します。
+    ///
+    /// @param[in] aLevel 記録レベル。
+    void StagePipeline::setRecordLevel(RecordLevel aLevel)
+    {
+        HPC_ASSERT(!isRunning());
+        for (int index = 0; index < BufferCount; ++index) {
+            mBuffers[index].stage.setRecordLevel(aLevel);
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// 生成スレッドを開始します。最初のステージから順に、全ステージを生成します。
+    ///
+    /// @param[in] aSystem ステージの生成に使うシステム用乱数。
+    ///                    全ステージを取り出すか cancel を呼ぶまで、他から使ってはいけません。
+    void StagePipeline::start(Random& aSystem)
+    {
+        HPC_ASSERT(!isRunning());
+        mSystem = &aSystem;
+        mGenerated.store(0);
+        mTaken.store(0);
+        mIsCancelled.store(false);
+        mThread = std::thread(&StagePipeline::threadMain, this);
+    }
+
+    //------------------------------------------------------------------------------
+    /// 生成したステージを取り出します。まだ生成されていない場合は、生成が終わるまで待ちます。
+    /// 最後のステージを取り出すと、生成スレッドの終了を待ちます。
+    ///
+    /// @param[in]  aStageIndex  取り出すステージの番号。 0 から順に指定する必要があります。
+    /// @param[out] aStage       取り出したステージの複製先。
+    /// @param[out] aSystemSeed  そのステージを生成する前のシステム用乱数の状態。
+    void StagePipeline::take(int aStageIndex, Stage& aStage, uint aSystemSeed[2])
+    {
+        HPC_ASSERT(isRunning());
+        HPC_ASSERT(aStageIndex == mTaken.load(std::memory_order_relaxed));
+        while (mGenerated.load(std::memory_order_acquire) <= aStageIndex) {
+            std::this_thread::yield();
+        }
+        const Buffer& buffer = mBuffers[aStageIndex % BufferCount];
+        aStage.set(buffer.stage);
+        aSystemSeed[0] = buffer.systemSeed[0];
+        aSystemSeed[1] = buffer.systemSeed[1];
+        mTaken.store(aStageIndex + 1, std::memory_order_release);
+        if (aStageIndex + 1 == Parameter::GameStageCount) {
+            mThread.join();
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// 生成を打ち切り、生成スレッドの終了を待ちます。
+    /// 打ち切った場合、システム用乱数の状態は順に生成した場合と一致しません。
+    void StagePipeline::cancel()
+    {
+        if (!isRunning()) {
+            return;
+        }
+        mIsCancelled.store(true);
+        mThread.join();
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 生成スレッドが動いている場合は @c true 。
+    bool StagePipeline::isRunning()const
+    {
+        return mThread.joinable();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 生成スレッドの処理です。空いたバッファに、ステージ番号の順に生成します。
+    void StagePipeline::threadMain()
+    {
+        Tracer::NameThread("StageGenerator");
+        for (int index = 0; index < Parameter::GameStageCount; ++index) {
+            while (index - mTaken.load(std::memory_order_acquire) >= BufferCount) {
+                if (mIsCancelled.load()) {
+                    return;
+                }
+                // 1 ステージの実行には生成よりも時間がかかるので、
+                // 空きを待つ間は CPU を使わないように休む。
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            Buffer& buffer = mBuffers[index % BufferCount];
+            buffer.systemSeed[0] = mSystem->seedX();
+            buffer.systemSeed[1] = mSystem->seedY();
+            Tracer::Begin("Generate", index);
+            LevelDesigner::Setup(index, buffer.stage, *mSystem);
+            Tracer::End("Generate");
+            mGenerated.store(index + 1, std::memory_order_release);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
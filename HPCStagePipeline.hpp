@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    StagePipeline クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include "HPCRandom.hpp"
+#include "HPCRecordLevel.hpp"
+#include "HPCStage.hpp"
+#include "HPCTypes.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief 次のステージの生成を、現在のステージの実行と並行して別スレッドで行います。
+    ///
+    /// 生成スレッドはシステム用乱数を 1 つだけ使い、ステージ番号の順に LevelDesigner::Setup を呼ぶので、
+    /// 乱数の消費順と生成されるステージは順に生成した場合と同じです。
+    /// 生成したステージは 2 つのバッファに交互に置かれ、 take で取り出されるまで上書きされません。
+    /// 生成中はシステム用乱数を生成スレッドが使うため、他から使ってはいけません。
+    class StagePipeline
+    {
+    public:
+        static const int BufferCount = 2;                   ///< 生成したステージを置くバッファの数
+
+        StagePipeline();
+        ~StagePipeline();
+
+        void setRecordLevel(RecordLevel aLevel);            ///< 生成するステージの記録レベルを設定します。
+        void start(Random& aSystem);                        ///< 生成スレッドを開始します。
+        void take(int aStageIndex, Stage& aStage, uint aSystemSeed[2]); ///< 生成したステージを取り出します。
+        void cancel();                                      ///< 生成を打ち切り、生成スレッドの終了を待ちます。
+        bool isRunning()const;                             ///< 生成スレッドが動いているかどうかを返します。
+
+    private:
+        /// 生成したステージを置くバッファ
+        struct Buffer
+        {
+            Stage stage;                                    ///< 生成したステージ
+            uint systemSeed[2];                             ///< 生成前のシステム用乱数の状態
+        };
+
+        Random* mSystem;                                    ///< ステージの生成に使うシステム用乱数
+        Buffer mBuffers[BufferCount];                       ///< 生成したステージ
+        std::thread mThread;                                ///< 生成スレッド
+        std::atomic<int> mGenerated;                        ///< 生成し終えたステージ数 (生成スレッドのみが書き換える)
+        std::atomic<int> mTaken;                            ///< 取り出したステージ数 (実行側のみが書き換える)
+        std::atomic<bool> mIsCancelled;                     ///< 生成を打ち切るか
+
+        void threadMain();                                  ///< 生成スレッドの処理です。
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
@@ -0,0 +1,231 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCStageScheduler.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCStageScheduler.hpp"
+
+#include <chrono>
+#include <thread>
+#include "HPCCommon.hpp"
+#include "HPCLevelDesigner.hpp"
+#include "HPCTracer.hpp"
+
+namespace {
+
+    /// 計測に使う時計
+    typedef std::chrono::steady_clock Clock;
+
+    //------------------------------------------------------------------------------
+    /// 2 つの時刻の間の秒数を返します。
+    double PastSec(const Clock::time_point& aBegin, const Clock::time_point& aEnd)
+    {
+        return std::chrono::duration<double>(aEnd - aBegin).count();
+    }
+}
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    StageScheduler::StageScheduler()
+        : mQueues()
+        , mWorkerCount(0)
+        , mMakespanSec(0.0)
+        , mWorkSec(0.0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// 実行環境のハードウェアスレッド数を、 WorkerCountMax を上限として返します。
+    ///
+    /// @return 既定のワーカー数。 1 以上です。
+    int StageScheduler::DefaultWorkerCount()
+    {
+        const int count = static_cast<int>(std::thread::hardware_concurrency());
+        if (count < 1) {
+            return 1;
+        }
+        return count < WorkerCountMax ? count : WorkerCountMax;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 0 から aStageCount - 1 までのステージの処理を、 aWorkerCount 個のワーカーで行います。
+    /// ワーカーの 1 つは呼び出したスレッドが務め、全ステージの処理が終わるまで戻りません。
+    ///
+    /// @param[in] aTask        ステージ単位の処理。
+    /// @param[in] aStageCount  処理するステージ数。
+    /// @param[in] aWorkerCount ワーカー数。 1 以上 WorkerCountMax 以下である必要があります。
+    void StageScheduler::run(StageTask& aTask, int aStageCount, int aWorkerCount)
+    {
+        HPC_RANGE_ASSERT_MIN_MAX_I(aStageCount, 0, Parameter::GameStageCount);
+        HPC_RANGE_ASSERT_MIN_MAX_I(aWorkerCount, 1, WorkerCountMax);
+
+        int order[Parameter::GameStageCount];
+        int workerOf[Parameter::GameStageCount];
+        plan(aStageCount, aWorkerCount, order, workerOf);
+        for (int worker = 0; worker < aWorkerCount; ++worker) {
+            mQueues[worker].head = 0;
+            mQueues[worker].tail = 0;
+            mQueues[worker].remainingCost = 0.0;
+            mQueues[worker].stolenCount = 0;
+            mQueues[worker].workSec = 0.0;
+        }
+        for (int index = 0; index < aStageCount; ++index) {
+            const int stageIndex = order[index];
+            Queue& queue = mQueues[workerOf[stageIndex]];
+            queue.stages[queue.tail++] = stageIndex;
+            queue.remainingCost += LevelDesigner::EstimateCost(stageIndex);
+        }
+        mWorkerCount = aWorkerCount;
+
+        const Clock::time_point begin = Clock::now();
+        std::thread threads[WorkerCountMax];
+        for (int worker = 1; worker < aWorkerCount; ++worker) {
+            threads[worker] = std::thread(&StageScheduler::workerMain, this, &aTask, worker);
+        }
+        workerMain(&aTask, 0);
+        for (int worker = 1; worker < aWorkerCount; ++worker) {
+            threads[worker].join();
+        }
+        mMakespanSec = PastSec(begin, Clock::now());
+
+        mWorkSec = 0.0;
+        for (int worker = 0; worker < aWorkerCount; ++worker) {
+            mWorkSec += mQueues[worker].workSec;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 最後に行った run のワーカー数。
+    int StageScheduler::workerCount()const
+    {
+        return mWorkerCount;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 最後に行った run の、開始から全ワーカーが終わるまでの時間 [秒] 。
+    double StageScheduler::makespanSec()const
+    {
+        return mMakespanSec;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 最後に行った run で処理した各ステージの時間の合計 [秒] 。
+    double StageScheduler::workSec()const
+    {
+        return mWorkSec;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 最後に行った run で、他のワーカーから譲り受けた回数。
+    int StageScheduler::stealCount()const
+    {
+        int count = 0;
+        for (int worker = 0; worker < mWorkerCount; ++worker) {
+            count += mQueues[worker].stolenCount;
+        }
+        return count;
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージを見積もりの大きい順に並べ、それまでの割り当てが最も少ないワーカーに順に割り当てます。
+    ///
+    /// @param[in]  aStageCount  割り当てるステージ数。
+    /// @param[in]  aWorkerCount ワーカー数。
+    /// @param[out] aOrder       見積もりの大きい順に並べたステージ番号。
+    /// @param[out] aWorkerOf    ステージ番号ごとの、割り当てたワーカー。
+    void StageScheduler::plan(int aStageCount, int aWorkerCount, int aOrder[], int aWorkerOf[])const
+    {
+        // ステージ数は高々 100 なので挿入ソートで並べる。
+        for (int index = 0; index < aStageCount; ++index) {
+            const int stageIndex = index;
+            const double cost = LevelDesigner::EstimateCost(stageIndex);
+            int pos = index;
+            while (pos > 0 && LevelDesigner::EstimateCost(aOrder[pos - 1]) < cost) {
+                aOrder[pos] = aOrder[pos - 1];
+                --pos;
+            }
+            aOrder[pos] = stageIndex;
+        }
+        double loads[WorkerCountMax] = {};
+        for (int index = 0; index < aStageCount; ++index) {
+            int target = 0;
+            for (int worker = 1; worker < aWorkerCount; ++worker) {
+                if (loads[worker] < loads[target]) {
+                    target = worker;
+                }
+            }
+            aWorkerOf[aOrder[index]] = target;
+            loads[target] += LevelDesigner::EstimateCost(aOrder[index]);
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// 次に処理するステージを取り出します。
+    /// 自分の割り当てがあれば最も大きいものを、無ければ残りが最も多いワーカーから最も小さいものを取り出します。
+    ///
+    /// @param[in] aWorkerIndex 取り出すワーカー。
+    ///
+    /// @return ステージ番号。どのワーカーにも残っていなければ -1 。
+    int StageScheduler::takeStage(int aWorkerIndex)
+    {
+        {
+            Queue& queue = mQueues[aWorkerIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.head < queue.tail) {
+                const int stageIndex = queue.stages[queue.head++];
+                queue.remainingCost -= LevelDesigner::EstimateCost(stageIndex);
+                return stageIndex;
+            }
+        }
+        while (true) {
+            // 残りの見積もりは他のワーカーが並行して書き換えるので、目安として読む。
+            int victim = -1;
+            double victimCost = 0.0;
+            for (int worker = 0; worker < mWorkerCount; ++worker) {
+                std::lock_guard<std::mutex> lock(mQueues[worker].mutex);
+                if (mQueues[worker].head < mQueues[worker].tail && victimCost <= mQueues[worker].remainingCost) {
+                    victim = worker;
+                    victimCost = mQueues[worker].remainingCost;
+                }
+            }
+            if (victim < 0) {
+                return -1;
+            }
+            Queue& queue = mQueues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            // 調べてから取り出すまでの間に、他のワーカーが取り出していることがある。
+            if (queue.head < queue.tail) {
+                const int stageIndex = queue.stages[--queue.tail];
+                queue.remainingCost -= LevelDesigner::EstimateCost(stageIndex);
+                ++queue.stolenCount;
+                return stageIndex;
+            }
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// ワーカーの処理です。取り出すステージが無くなるまで処理し、掛かった時間を記録します。
+    ///
+    /// @param[in] aTask        ステージ単位の処理。
+    /// @param[in] aWorkerIndex ワーカー番号。
+    void StageScheduler::workerMain(StageTask* aTask, int aWorkerIndex)
+    {
+        Tracer::NameThread("Worker");
+        for (int stageIndex = takeStage(aWorkerIndex); stageIndex >= 0; stageIndex = takeStage(aWorkerIndex)) {
+            const Clock::time_point begin = Clock::now();
+            aTask->runStage(stageIndex, aWorkerIndex);
+            // 自分の割り当てにだけ書き込むので、ワーカー間で競合しない。
+            mQueues[aWorkerIndex].workSec += PastSec(begin, Clock::now());
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
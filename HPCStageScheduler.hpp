@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    StageTask, StageScheduler クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <mutex>
+#include "HPCParameter.hpp"
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief StageScheduler で実行する、ステージ単位の処理を表します。
+    ///
+    /// runStage は複数のスレッドから同時に呼ばれます。
+    /// 同じ aWorkerIndex で同時に呼ばれることはないので、ワーカーごとに作業領域を分けて使えます。
+    class StageTask
+    {
+    public:
+        virtual ~StageTask() {}
+        virtual void runStage(int aStageIndex, int aWorkerIndex) = 0; ///< 1 ステージ分の処理を行います。
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief 互いに独立したステージ単位の処理を、複数のスレッドで分担して実行します。
+    ///
+    /// 各ステージの手間は LevelDesigner::EstimateCost で見積もります。
+    /// 実行するときは、見積もりの大きい順に、それまでの割り当てが最も少ないワーカーに割り当てます。
+    /// 各ワーカーは自分の割り当てを大きい順に処理し、無くなったら、残りが最も多いワーカーから
+    /// 最も小さいものを譲り受けます。
+    class StageScheduler
+    {
+    public:
+        static const int WorkerCountMax = 8;                ///< ワーカーの最大数
+
+        StageScheduler();
+
+        static int DefaultWorkerCount();                    ///< 既定のワーカー数を返します。
+
+        void run(StageTask& aTask, int aStageCount, int aWorkerCount); ///< 全ステージの処理を行います。
+
+        /// @name 最後に行った run の結果
+        //@{
+        int workerCount()const;                            ///< ワーカー数を返します。
+        double makespanSec()const;                         ///< 開始から全ワーカーが終わるまでの時間を返します。
+        double workSec()const;                             ///< 各ステージの処理時間の合計を返します。
+        int stealCount()const;                             ///< 他のワーカーから譲り受けた回数を返します。
+        //@}
+
+    private:
+        /// ワーカーごとの割り当て
+        struct Queue
+        {
+            std::mutex mutex;                               ///< 割り当ての操作を排他する
+            int stages[Parameter::GameStageCount];          ///< 割り当てたステージ番号 (見積もりの大きい順)
+            int head;                                       ///< 次に自分で処理する位置
+            int tail;                                       ///< 割り当ての終わり
+            double remainingCost;                           ///< まだ処理していない分の見積もり
+            int stolenCount;                                ///< 他のワーカーに譲った回数
+            double workSec;                                 ///< 処理に掛かった時間の合計
+        };
+
+        Queue mQueues[WorkerCountMax];                      ///< ワーカーごとの割り当て
+        int mWorkerCount;                                   ///< 最後に行った run のワーカー数
+        double mMakespanSec;                                ///< 最後に行った run の終了時間
+        double mWorkSec;                                    ///< 最後に行った run の処理時間の合計
+
+        void plan(int aStageCount, int aWorkerCount, int aOrder[], int aWorkerOf[])const; ///< 見積もりの大きい順に割り当てます。
+        int takeStage(int aWorkerIndex);                    ///< 次に処理するステージを取り出します。
+        void workerMain(StageTask* aTask, int aWorkerIndex); ///< ワーカーの処理です。
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
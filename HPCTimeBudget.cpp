@@ -0,0 +1,262 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCTimeBudget.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCTimeBudget.hpp"
+
+#include <chrono>
+#include "HPCCommon.hpp"
+#include "HPCLevelDesigner.hpp"
+#include "HPCMath.hpp"
+#include "HPCTimer.hpp"
+
+namespace {
+
+    //------------------------------------------------------------------------------
+    /// @return 単調に増える時計の現在時刻 [秒] 。
+    double NowSec()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+namespace hpc {
+
+    /// Timer はプロセス全体の CPU 時間を測るので、解答プログラム以外のスレッドの分も見込んで 1 割を残す。
+    const double TimeBudget::AnswerShare = 0.9;
+
+    //------------------------------------------------------------------------------
+    /// クラスのインスタンスを生成します。
+    ///
+    /// @note 生成しただけでは割り当てを行いません。 start 関数を呼び出す必要があります。
+    TimeBudget::TimeBudget()
+        : mLimitSec(-1.0)
+        , mWeights()
+        , mRestWeight(0.0)
+        , mStageIndex(-1)
+        , mStageTurnCount(0)
+        , mStageBeginSec(0.0)
+        , mAnswerSec(0.0)
+        , mAnswerBeginSec(-1.0)
+        , mBudgetSecs()
+        , mUsedSecs()
+        , mStageCount(0)
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    /// ゲームの開始時に呼び出します。
+    /// 各ステージの手間を LevelDesigner::EstimateSolveCost で見積もっておきます。
+    ///
+    /// @param[in] aTimer ゲームタイマー。制限時間だけを読み出します。
+    void TimeBudget::start(const Timer& aTimer)
+    {
+        mLimitSec = aTimer.limitSec() * AnswerShare;
+        mRestWeight = 0.0;
+        for (int index = 0; index < Parameter::GameStageCount; ++index) {
+            mWeights[index] = LevelDesigner::EstimateSolveCost(index);
+            mRestWeight += mWeights[index];
+            mBudgetSecs[index] = 0.0;
+            mUsedSecs[index] = 0.0;
+        }
+        mStageIndex = -1;
+        mStageTurnCount = 0;
+        mStageBeginSec = 0.0;
+        mAnswerSec = 0.0;
+        mAnswerBeginSec = -1.0;
+        mStageCount = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージの開始時に呼び出し、残り時間からこのステージの時間を割り当てます。
+    ///
+    /// 残り時間をこのステージ以降の見積もりの合計で割って配分するので、
+    /// それまでのステージの使いすぎや余りが残りのステージに均等にならされます。
+    ///
+    /// @param[in] aStageIndex 開始するステージ番号。
+    ///
+    /// @pre start 関数が呼ばれている必要があります。
+    void TimeBudget::startStage(int aStageIndex)
+    {
+        HPC_ASSERT(isStarted());
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        mStageIndex = aStageIndex;
+        mStageTurnCount = LevelDesigner::EstimateTurnCount(aStageIndex);
+        mStageBeginSec = answerSec();
+        const double restSec = mStageBeginSec < mLimitSec ? mLimitSec - mStageBeginSec : 0.0;
+        // 見積もりの合計は浮動小数点の誤差で小さくなり得るので、このステージの見積もりを下限とする。
+        const double restWeight = mRestWeight > mWeights[aStageIndex] ? mRestWeight : mWeights[aStageIndex];
+        mBudgetSecs[aStageIndex] = restWeight > 0.0 ? restSec * mWeights[aStageIndex] / restWeight : restSec;
+        mRestWeight -= mWeights[aStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージの終了時に呼び出し、使った時間を記録します。
+    ///
+    /// @pre startStage 関数が呼ばれている必要があります。
+    void TimeBudget::endStage()
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(mStageIndex, 0, Parameter::GameStageCount);
+        mUsedSecs[mStageIndex] = stagePastSec();
+        mStageCount = mStageIndex + 1;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 解答プログラムを呼び出す直前に呼び出し、呼び出しの間の時間を計測し始めます。
+    void TimeBudget::beginAnswer()
+    {
+        HPC_ASSERT(mAnswerBeginSec < 0.0);
+        mAnswerBeginSec = NowSec();
+    }
+
+    //------------------------------------------------------------------------------
+    /// 解答プログラムから戻った直後に呼び出し、呼び出しの間の時間を加えます。
+    ///
+    /// @pre beginAnswer 関数が呼ばれている必要があります。
+    void TimeBudget::endAnswer()
+    {
+        HPC_ASSERT(0.0 <= mAnswerBeginSec);
+        mAnswerSec += NowSec() - mAnswerBeginSec;
+        mAnswerBeginSec = -1.0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return start 関数が呼ばれている場合 @c true 。
+    ///         リプレイの再シミュレーションなど、ゲームの外では @c false です。
+    bool TimeBudget::isStarted()const
+    {
+        return 0.0 <= mLimitSec;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 実行中のステージ番号。ステージを開始していない場合は -1 。
+    int TimeBudget::stageIndex()const
+    {
+        return mStageIndex;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 解答プログラムの呼び出し中に呼ばれた場合は、その呼び出しで経過した時間も含めます。
+    ///
+    /// @return ゲームの開始から、解答プログラムの呼び出しの間に経過した時間の合計 [秒] 。
+    double TimeBudget::answerSec()const
+    {
+        return mAnswerBeginSec < 0.0 ? mAnswerSec : mAnswerSec + (NowSec() - mAnswerBeginSec);
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 実行中のステージに割り当てた時間 [秒] 。
+    double TimeBudget::stageBudgetSec()const
+    {
+        if (mStageIndex < 0) {
+            return 0.0;
+        }
+        return mBudgetSecs[mStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 実行中のステージを開始してから、解答プログラムが使った時間 [秒] 。
+    double TimeBudget::stagePastSec()const
+    {
+        if (mStageIndex < 0) {
+            return 0.0;
+        }
+        return answerSec() - mStageBeginSec;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 実行中のステージの割り当ての残り [秒] 。使いすぎた場合は負の値になります。
+    double TimeBudget::stageRestSec()const
+    {
+        return stageBudgetSec() - stagePastSec();
+    }
+
+    //------------------------------------------------------------------------------
+    /// ステージの残り時間を、見積もったターン数のうち残っている分で割った値を返します。
+    /// 見積もりより長引いた場合は、残り時間をすべて使ってよいものとします。
+    ///
+    /// @param[in] aPassedTurn 経過したターン数。
+    ///
+    /// @return 実行中のターンに使ってよい時間の目安 [秒] 。割り当てを使い切った場合は 0 。
+    double TimeBudget::turnBudgetSec(int aPassedTurn)const
+    {
+        const int restTurnCount = Math::Max(mStageTurnCount - aPassedTurn, 1);
+        const double restSec = stageRestSec();
+        return restSec > 0.0 ? restSec / restTurnCount : 0.0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @return 実行中のステージの割り当てを使い切った場合 @c true 。
+    ///         ゲームの外では常に @c false です。
+    bool TimeBudget::isStageOver()const
+    {
+        return isStarted() && mStageIndex >= 0 && stageRestSec() <= 0.0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aStageIndex ステージ番号。
+    ///
+    /// @return 指定ステージの開始時に割り当てた時間 [秒] 。
+    double TimeBudget::budgetSec(int aStageIndex)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        return mBudgetSecs[aStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    /// @param[in] aStageIndex ステージ番号。
+    ///
+    /// @return 指定ステージで使った時間 [秒] 。終了していないステージでは 0 。
+    double TimeBudget::usedSec(int aStageIndex)const
+    {
+        HPC_RANGE_ASSERT_MIN_UB_I(aStageIndex, 0, Parameter::GameStageCount);
+        return mUsedSecs[aStageIndex];
+    }
+
+    //------------------------------------------------------------------------------
+    /// 終了したステージについて、割り当てに対して最も多く使った割合と、使いすぎたステージ数を表示します。
+    void TimeBudget::dump()const
+    {
+        int overCount = 0;
+        int maxRateIndex = -1;
+        double maxRate = 0.0;
+        double usedSum = 0.0;
+        for (int index = 0; index < mStageCount; ++index) {
+            usedSum += mUsedSecs[index];
+            if (mUsedSecs[index] > mBudgetSecs[index]) {
+                ++overCount;
+            }
+            if (mBudgetSecs[index] > 0.0 && mUsedSecs[index] / mBudgetSecs[index] > maxRate) {
+                maxRate = mUsedSecs[index] / mBudgetSecs[index];
+                maxRateIndex = index;
+            }
+        }
+        HPC_PRINT_LOG(
+            "Budget", "answer used %.4f / %.1f sec, over %d stages, max rate %.4f (stage %d)\n"
+            , usedSum
+            , isStarted() ? mLimitSec : 0.0
+            , overCount
+            , maxRate
+            , maxRateIndex
+            );
+    }
+
+    //------------------------------------------------------------------------------
+    /// ゲーム全体の割り当てを取得します。
+    ///
+    /// @return Simulation が開始時に設定する割り当てへの参照。
+    TimeBudget& TimeBudget::Current()
+    {
+        static TimeBudget sBudget;
+        return sBudget;
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
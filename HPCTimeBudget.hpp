@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    TimeBudget クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "HPCParameter.hpp"
+
+namespace hpc {
+
+    class Timer;
+
+    //------------------------------------------------------------------------------
+    /// @brief ゲーム全体の制限時間を、各ステージとターンに割り当てます。
+    ///
+    /// 時間は解答プログラムの呼び出しの間だけを std::chrono::steady_clock で測ります。
+    /// 生成スレッドや JSON の出力スレッドの CPU 時間は含まないので、出力の形式によって割り当ては変わりません。
+    ///
+    /// ステージの開始ごとに、残り時間を残りのステージへ手間の見積もりに比例して配分し直します。
+    /// 前のステージで使いすぎた分や余った分は、後のステージの割り当てに反映されます。
+    /// 解答プログラムは StageAccessor::timeBudget() を通じて値を読み出します。
+    class TimeBudget
+    {
+    public:
+        /// 制限時間のうち解答プログラムに割り当てる割合。残りはシミュレーションと他のスレッドの分とする。
+        static const double AnswerShare;
+
+        TimeBudget();
+
+        /// @name 割り当てを行う関数
+        //@{
+        void start(const Timer& aTimer);                    ///< ゲームの開始時に制限時間を設定します。
+        void startStage(int aStageIndex);                   ///< ステージの開始時に、このステージの時間を割り当てます。
+        void endStage();                                    ///< ステージの終了時に、使った時間を記録します。
+        void beginAnswer();                                 ///< 解答プログラムの呼び出しの前に、計測を開始します。
+        void endAnswer();                                   ///< 解答プログラムの呼び出しの後に、計測を終了します。
+        //@}
+
+        /// @name 割り当てを読み出す関数
+        //@{
+        bool isStarted()const;                             ///< ゲームが開始しているかを返します。
+        int stageIndex()const;                             ///< 実行中のステージ番号を返します。
+        double answerSec()const;                           ///< ゲームの開始から解答プログラムが使った時間を返します。
+        double stageBudgetSec()const;                      ///< 実行中のステージに割り当てた時間を返します。
+        double stagePastSec()const;                        ///< 実行中のステージで使った時間を返します。
+        double stageRestSec()const;                        ///< 実行中のステージの残り時間を返します。
+        double turnBudgetSec(int aPassedTurn)const;        ///< 実行中のターンに使ってよい時間の目安を返します。
+        bool isStageOver()const;                           ///< 実行中のステージの割り当てを使い切ったかを返します。
+        double budgetSec(int aStageIndex)const;            ///< 指定ステージに割り当てた時間を返します。
+        double usedSec(int aStageIndex)const;              ///< 指定ステージで使った時間を返します。
+        //@}
+
+        void dump()const;                                  ///< 割り当てと実績の要約を画面に表示します。
+
+        static TimeBudget& Current();                       ///< ゲーム全体の割り当てを取得します。
+
+    private:
+        double mLimitSec;                                   ///< 解答プログラムに割り当てる時間の合計。開始前は負の値
+        double mWeights[Parameter::GameStageCount];         ///< ステージごとの手間の見積もり
+        double mRestWeight;                                 ///< まだ開始していないステージの見積もりの合計
+        int mStageIndex;                                    ///< 実行中のステージ番号
+        int mStageTurnCount;                                ///< 実行中のステージの見積もりターン数
+        double mStageBeginSec;                              ///< 実行中のステージを開始したときの answerSec
+        double mAnswerSec;                                  ///< 終了した呼び出しで解答プログラムが使った時間の合計
+        double mAnswerBeginSec;                             ///< 呼び出し中であれば、その開始時刻。そうでなければ負の値
+        double mBudgetSecs[Parameter::GameStageCount];      ///< ステージごとに割り当てた時間
+        double mUsedSecs[Parameter::GameStageCount];        ///< ステージごとに使った時間
+        int mStageCount;                                    ///< 終了したステージの数
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
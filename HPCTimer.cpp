@@ -65,6 +65,13 @@ namespace hpc {
         return ToSec(GetCurrentTime() - mTimeBegin);
     }
 
+    //------------------------------------------------------------------------------
+    /// @return 制限時間 [秒] 。
+    int Timer::limitSec()const
+    {
+        return mLimitSec;
+    }
+
     //------------------------------------------------------------------------------
     /// 表示用に修正された時間を表示します。
     ///
@@ -24,6 +24,7 @@ namespace hpc {
         void start();                       ///< タイマーを開始します。
         bool isInTime()const;              ///< 制限時間内かどうかを返します。
         double pastSecForPrint()const;     ///< 表示用の経過時間を取得します。
+        int limitSec()const;               ///< 制限時間を取得します。
 
     private:
         double pastSec()const;             ///< 経過時間を取得します。
@@ -0,0 +1,246 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    HPCTracer.hpp の実装
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+
+#include "HPCTracer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include "HPCCommon.hpp"
+#include "HPCMath.hpp"
+
+namespace {
+
+    /// 記録に使う時計。 std::clock はプロセス全体の CPU 時間で、他のスレッドが動くと進み方が変わるので使わない。
+    typedef std::chrono::steady_clock Clock;
+
+    /// 記録した 1 つのイベント
+    struct TraceEvent
+    {
+        const char* name;                                   ///< 区間の名前
+        Clock::time_point time;                             ///< 時刻
+        int arg;                                            ///< 付加情報。負なら無し
+        char phase;                                         ///< 'B' なら開始、 'E' なら終了
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief 1 つのスレッドが記録するイベントのバッファです。
+    ///
+    /// 書き込むのは所有するスレッドだけなので、ロックは必要ありません。
+    class TraceBuffer
+    {
+    public:
+        static const int Capacity = 1 << 12;                ///< 溜めておけるイベント数
+
+        TraceBuffer()
+            : mThreadId(0)
+            , mCount(0)
+        {
+        }
+
+        /// 書き出すときのスレッド番号を設定します。
+        void setThreadId(int aThreadId)
+        {
+            mThreadId = aThreadId;
+        }
+
+        /// @return 書き出すときのスレッド番号。
+        int threadId()const
+        {
+            return mThreadId;
+        }
+
+        /// イベントを追加します。一杯になったら書き出します。
+        void push(const char* aName, char aPhase, int aArg)
+        {
+            TraceEvent& event = mEvents[mCount];
+            event.name = aName;
+            event.time = Clock::now();
+            event.arg = aArg;
+            event.phase = aPhase;
+            if (++mCount == Capacity) {
+                flush();
+            }
+        }
+
+        void flush();                                       ///< 溜めたイベントをファイルに書き出します。
+
+    private:
+        int mThreadId;                                      ///< 書き出すときのスレッド番号
+        int mCount;                                         ///< 溜めているイベント数
+        TraceEvent mEvents[Capacity];                       ///< イベント
+    };
+
+    /// 記録できるスレッドの数。
+    /// スレッドの終了時にバッファを返す仕組みは無いので、ゲーム中に作られるスレッドの合計を収める。
+    const int BufferCountMax = 64;
+
+    std::FILE* sFile = 0;                                   ///< 出力先。記録中でなければ 0
+    bool sIsFirstEvent = true;                              ///< まだイベントを書き出していないか
+    Clock::time_point sOpenTime;                            ///< 記録を開始した時刻。 ts はここからの経過時間
+    std::mutex sFileMutex;                                  ///< 出力先への書き出しを排他する
+    std::atomic<int> sBufferCount(0);                       ///< 使い始めたバッファの数
+    TraceBuffer sBuffers[BufferCountMax];                   ///< スレッドごとのバッファ
+    HPC_THREAD_LOCAL TraceBuffer* sThreadBuffer = 0;        ///< このスレッドのバッファ。まだ記録していなければ 0
+
+    //------------------------------------------------------------------------------
+    /// 呼び出したスレッドのバッファを返します。初めて呼ばれたときに空いているバッファを割り当てます。
+    ///
+    /// @return バッファ。スレッドの数が BufferCountMax を超えた場合は 0 で、そのスレッドは記録しません。
+    TraceBuffer* ThreadBuffer()
+    {
+        if (!sThreadBuffer) {
+            const int index = sBufferCount.fetch_add(1);
+            if (index >= BufferCountMax) {
+                return 0;
+            }
+            sThreadBuffer = &sBuffers[index];
+            sThreadBuffer->setThreadId(index);
+        }
+        return sThreadBuffer;
+    }
+
+    //------------------------------------------------------------------------------
+    /// イベントを区切る文字を書き出します。 sFileMutex を取得した状態で呼び出します。
+    void PutSeparator()
+    {
+        std::fputs(sIsFirstEvent ? "\n" : ",\n", sFile);
+        sIsFirstEvent = false;
+    }
+
+    //------------------------------------------------------------------------------
+    void TraceBuffer::flush()
+    {
+        std::lock_guard<std::mutex> lock(sFileMutex);
+        for (int index = 0; index < mCount; ++index) {
+            const TraceEvent& event = mEvents[index];
+            const double micros = std::chrono::duration<double, std::micro>(event.time - sOpenTime).count();
+            PutSeparator();
+            std::fprintf(
+                sFile
+                , "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%d"
+                , event.name
+                , event.phase
+                , micros
+                , mThreadId
+                );
+            if (0 <= event.arg) {
+                std::fprintf(sFile, ",\"args\":{\"index\":%d}", event.arg);
+            }
+            std::fputc('}', sFile);
+        }
+        mCount = 0;
+    }
+}
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// 出力先のファイルを開き、記録を開始します。
+    ///
+    /// @param[in] aFileName 出力先のファイル名。
+    ///
+    /// @return ファイルを開けた場合は @c true 。開けなかった場合は記録を行いません。
+    bool Tracer::Open(const char* aFileName)
+    {
+        HPC_ASSERT(!sFile);
+        sFile = std::fopen(aFileName, "w");
+        if (!sFile) {
+            HPC_PRINT("Tracer: cannot open %s.\n", aFileName);
+            return false;
+        }
+        sIsFirstEvent = true;
+        sOpenTime = Clock::now();
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", sFile);
+        // 開いたスレッドを先にスレッド番号 0 として登録しておく。
+        NameThread("Simulation");
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 残っているイベントを書き出し、出力先のファイルを閉じます。
+    ///
+    /// @pre 記録を行う他のスレッドは終了している必要があります。
+    void Tracer::Close()
+    {
+        if (!sFile) {
+            return;
+        }
+        const int bufferCount = Math::Min(sBufferCount.load(), BufferCountMax);
+        for (int index = 0; index < bufferCount; ++index) {
+            sBuffers[index].flush();
+        }
+        std::fputs("\n]}\n", sFile);
+        std::fclose(sFile);
+        sFile = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Tracer::IsEnabled()
+    {
+        return sFile != 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /// 呼び出したスレッドに、タイムラインに表示する名前を付けます。記録中でなければ何もしません。
+    ///
+    /// @param[in] aName スレッドの名前。
+    void Tracer::NameThread(const char* aName)
+    {
+        if (!sFile) {
+            return;
+        }
+        TraceBuffer* const buffer = ThreadBuffer();
+        if (!buffer) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(sFileMutex);
+        PutSeparator();
+        std::fprintf(
+            sFile
+            , "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}"
+            , buffer->threadId()
+            , aName
+            );
+    }
+
+    //------------------------------------------------------------------------------
+    /// 区間の開始を記録します。記録中でなければ何もしません。
+    ///
+    /// @param[in] aName 区間の名前。文字列リテラルなど、書き出すまで有効なものを指定します。
+    /// @param[in] aArg  区間に付加する番号。負の場合は付加しません。
+    void Tracer::Begin(const char* aName, int aArg)
+    {
+        if (sFile) {
+            TraceBuffer* const buffer = ThreadBuffer();
+            if (buffer) {
+                buffer->push(aName, 'B', aArg);
+            }
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /// 区間の終了を記録します。記録中でなければ何もしません。
+    ///
+    /// @param[in] aName 区間の名前。 Begin に指定したものと同じものを指定します。
+    void Tracer::End(const char* aName)
+    {
+        if (sFile) {
+            TraceBuffer* const buffer = ThreadBuffer();
+            if (buffer) {
+                buffer->push(aName, 'E', -1);
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// EOF
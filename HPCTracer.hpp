@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------
+/// @file
+/// @brief    Tracer クラス
+/// @author   ハル研究所プログラミングコンテスト実行委員会
+///
+/// @copyright  Copyright (c) 2014 HAL Laboratory, Inc.
+/// @attention  このファイルの利用は、同梱のREADMEにある
+///             利用条件に従ってください
+
+//------------------------------------------------------------------------------
+#pragma once
+
+namespace hpc {
+
+    //------------------------------------------------------------------------------
+    /// @brief 処理区間のタイムラインを Chrome の trace event 形式で出力します。
+    ///
+    /// Open() を呼ぶまでは何も記録しません。
+    /// 時刻は std::chrono::steady_clock で測り、 Open() からの経過時間として出力します。
+    /// 記録した区間は呼び出したスレッドごとのバッファに溜められ、
+    /// バッファが一杯になったときと Close() を呼んだときにまとめてファイルへ書き出されます。
+    /// スレッド番号は記録を始めた順に振られ、 Open() を呼んだスレッドが 0 になります。
+    /// 出力したファイルは chrome://tracing や Perfetto で読み込むことができます。
+    class Tracer
+    {
+    public:
+        static bool Open(const char* aFileName);            ///< 出力先を開き、記録を開始します。
+        static void Close();                                ///< 残りの記録を書き出し、出力先を閉じます。
+        static bool IsEnabled();                            ///< 記録中かどうかを返します。
+        static void NameThread(const char* aName);          ///< 呼び出したスレッドに名前を付けます。
+        static void Begin(const char* aName, int aArg = -1); ///< 区間の開始を記録します。
+        static void End(const char* aName);                 ///< 区間の終了を記録します。
+    };
+
+    //------------------------------------------------------------------------------
+    /// @brief スコープの間を Tracer の区間として記録します。
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(const char* aName)
+            : mName(aName)
+        {
+            Tracer::Begin(mName);
+        }
+        ~TraceScope()
+        {
+            Tracer::End(mName);
+        }
+
+    private:
+        const char* const mName;                            ///< 区間の名前
+    };
+}
+//------------------------------------------------------------------------------
+// EOF
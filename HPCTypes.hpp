@@ -13,5 +13,13 @@
 /// 符号なし整数型
 typedef unsigned int uint;
 
+/// スレッドごとに持つ変数の指定。
+/// Visual Studio 2013 は thread_local に対応していないため、同じ意味の指定を使う。
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define HPC_THREAD_LOCAL __declspec(thread)
+#else
+#define HPC_THREAD_LOCAL thread_local
+#endif
+
 //------------------------------------------------------------------------------
 // EOF
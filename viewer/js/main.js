@@ -6,13 +6,14 @@
 angular.module('viewer', []).config(function ($locationProvider) {
   'use strict';
   $locationProvider.html5Mode(true);
-}).controller('ViewerController', function ($scope, $location, $timeout, $window) {
+}).controller('ViewerController', function ($scope, $location, $window) {
   'use strict';
   var $slider = $('#slider'),
+    ScrubTrailTurns = 100,
     ninjaColor = ['#0000ff', '#8b4513', '#d2691e', '#b8860b'];
   $slider.slider();
 
-  $scope.isPlay = $scope.isShowInfo = false;
+  $scope.isPlay = $scope.isShowInfo = $scope.isScrubbing = false;
   $scope.wait = 50;
   $scope.currentStageNo = 0;
   $scope.currentTurnNo = 0;
@@ -21,6 +22,79 @@ angular.module('viewer', []).config(function ($locationProvider) {
     return ninjaColor[i];
   };
 
+  // 軌跡の間引き
+  // 進む向きが変わったターンと加速したターンだけを残した折れ線を、ステージごとに一度だけ作る
+  // スライダー操作中や全体の軌跡の表示ではこの折れ線を描き、再生中はターンごとに描く
+  (function (KeyframeSin) {
+    var keyframesOf = function (stage) {
+      var charaCount = stage.charaCount,
+        pos = stage.pos,
+        last = stage.turnCount - 1;
+      if (!stage.keyframes) {
+        stage.keyframes = _.times(charaCount, function (i) {
+          var keys = [0],
+            t,
+            p,
+            vx0,
+            vy0,
+            vx1,
+            vy1,
+            l0,
+            l1;
+          for (t = 1; t < last; t += 1) {
+            p = (t * charaCount + i) * 2;
+            vx0 = pos[p] - pos[p - charaCount * 2];
+            vy0 = pos[p + 1] - pos[p - charaCount * 2 + 1];
+            vx1 = pos[p + charaCount * 2] - pos[p];
+            vy1 = pos[p + charaCount * 2 + 1] - pos[p + 1];
+            l0 = Math.sqrt(vx0 * vx0 + vy0 * vy0);
+            l1 = Math.sqrt(vx1 * vx1 + vy1 * vy1);
+            if (stage.accelCounts[t * charaCount + i] !== stage.accelCounts[(t - 1) * charaCount + i]
+                || (l0 === 0) !== (l1 === 0)
+                || (l0 > 0 && l1 > 0 && Math.abs(vx0 * vy1 - vy0 * vx1) > KeyframeSin * l0 * l1)) {
+              keys.push(t);
+            }
+          }
+          if (last > 0) {
+            keys.push(last);
+          }
+          return new Uint16Array(keys);
+        });
+      }
+      return stage.keyframes;
+    };
+    // 指定した範囲のターンの軌跡を、間引いた折れ線でパスに加える
+    $scope.traceKeyframes = function (ctx, stage, i, from, to) {
+      var keys = keyframesOf(stage)[i],
+        pos = stage.pos,
+        // turn 以下のキーフレームの数を二分探索で求める
+        countTo = function (turn) {
+          var lo = 0,
+            hi = keys.length,
+            mid;
+          while (lo < hi) {
+            mid = (lo + hi) >> 1;
+            if (keys[mid] <= turn) {
+              lo = mid + 1;
+            } else {
+              hi = mid;
+            }
+          }
+          return lo;
+        },
+        end = countTo(to),
+        k,
+        p = (from * stage.charaCount + i) * 2;
+      ctx.moveTo(pos[p] * 10, pos[p + 1] * 10);
+      for (k = countTo(from); k < end; k += 1) {
+        p = (keys[k] * stage.charaCount + i) * 2;
+        ctx.lineTo(pos[p] * 10, pos[p + 1] * 10);
+      }
+      p = (to * stage.charaCount + i) * 2;
+      ctx.lineTo(pos[p] * 10, pos[p + 1] * 10);
+    };
+  }(0.005));
+
   // グリッド画像生成
   (function (canvas) {
     var ctx = canvas.getContext('2d');
@@ -41,34 +115,120 @@ angular.module('viewer', []).config(function ($locationProvider) {
     $('#grid').css('background-image', 'url(' + canvas.toDataURL('image/png') + ')');
   }($('#grid-img')[0]));
 
-  (function (conv) {
+  (function (convHeader, convStage, decodeBinary) {
+    var ChunkSize = 1024 * 1024,
+      // -b で出力したバイナリ
+      isBinary = function (name) {
+        return (/\.hpct$/).test(name);
+      },
+      // 1 行目が [半径,周回数] なら、ステージごとに 1 行の JSON Lines (-jl の出力)
+      isJsonLines = function (text) {
+        return (/^\[\s*[\-0-9.]+\s*,\s*[0-9]+\s*\]\s*$/).test(text.split('\n', 1)[0]);
+      },
+      // JSON 全体を変換
+      convAll = function (json) {
+        convHeader(json[0]);
+        $scope.stages = _.map(json[1], convStage);
+        $scope.currentStageNo = new Number(0);
+      },
+      // JSON Lines を受け取った分だけ変換する関数を作る
+      createLineReader = function () {
+        var rest = '',
+          isHeaderRead = false;
+        return function (text, isLast) {
+          var lines = (rest + text).split('\n');
+          rest = isLast ? '' : lines.pop();
+          _.each(lines, function (line) {
+            var json;
+            if (!$.trim(line)) {
+              return;
+            }
+            json = $.parseJSON(line);
+            if (!isHeaderRead) {
+              convHeader(json);
+              $scope.stages = [];
+              isHeaderRead = true;
+              return;
+            }
+            $scope.stages.push(convStage(json));
+            // 最初のステージが届いたらすぐに表示する
+            if ($scope.stages.length === 1) {
+              $scope.currentStageNo = new Number(0);
+            }
+          });
+        };
+      },
+      finishLoading = function () {
+        $scope.$apply(function () {
+          $scope.isNowLoading = false;
+        });
+      };
     // JSONファイルを読み込むイベントの設定
     if ($window.File && $window.FileReader && $window.FileList && $window.JSON) {
       $('#file').change(function (e) {
-        var fr = new FileReader();
+        var file = e.target.files[0],
+          readLines,
+          readChunk,
+          fr;
         $scope.$apply(function () {
           $scope.isNowLoading = true;
         });
-        fr.onload = (function () {
-          return function (e) {
-            var scope = angular.element('#viewer-controller').scope(),
-              json;
+        if (isBinary(file.name)) {
+          fr = new FileReader();
+          fr.onload = function (e) {
             try {
-              json = $.parseJSON(e.target.result);
+              $scope.$apply(function () {
+                decodeBinary(e.target.result);
+              });
             } catch (ee) {
-              alert('正しいJSONファイルではありません');
+              alert('正しいバイナリファイルではありません');
+            }
+            finishLoading();
+          };
+          fr.readAsArrayBuffer(file);
+          return;
+        }
+        // ChunkSize ずつ読み、JSON Lines であれば読んだステージから表示する
+        // 出力は ASCII のみなので、区切りで文字が分断されることはない
+        readChunk = function (offset) {
+          var fr = new FileReader();
+          fr.onload = function (e) {
+            var text = e.target.result,
+              isLast = offset < 0 || offset + ChunkSize >= file.size;
+            if (offset === 0) {
+              if (isJsonLines(text)) {
+                readLines = createLineReader();
+              } else if (!isLast) {
+                // JSON Lines でなければ全体を読み直す
+                readChunk(-1);
+                return;
+              }
             }
-            if (json) {
-              scope.$apply(function () {
-                conv(json);
+            try {
+              $scope.$apply(function () {
+                if (readLines) {
+                  readLines(text, isLast);
+                  // 最初のステージを表示できたら、残りは読み込みながら操作できる
+                  $scope.isNowLoading = !$scope.stages || !$scope.stages.length;
+                } else {
+                  convAll($.parseJSON(text));
+                }
               });
+            } catch (ee) {
+              alert('正しいJSONファイルではありません');
+              finishLoading();
+              return;
             }
-            $scope.$apply(function () {
-              $scope.isNowLoading = false;
-            });
+            if (readLines && !isLast) {
+              readChunk(offset + ChunkSize);
+              return;
+            }
+            finishLoading();
           };
-        }(e.target.files[0]));
-        fr.readAsText(e.target.files[0]);
+          fr.readAsText(offset < 0 ? file : file.slice(offset, offset + ChunkSize));
+        };
+        readLines = null;
+        readChunk(0);
       });
     } else {
       alert('最新のブラウザを使用してください');
@@ -76,46 +236,139 @@ angular.module('viewer', []).config(function ($locationProvider) {
     // URLでjsonファイルを指定している場合は、そのファイルを読み込む
     if ($location.search().data) {
       $scope.isNowLoading = true;
-      $.getJSON($location.search().data, function (json) {
-        $scope.$apply(function () {
-          conv(json);
-          $scope.isNowLoading = false;
+      if (isBinary($location.search().data)) {
+        (function (xhr) {
+          xhr.responseType = 'arraybuffer';
+          xhr.onload = function () {
+            $scope.$apply(function () {
+              decodeBinary(xhr.response);
+            });
+            finishLoading();
+          };
+          xhr.open('GET', $location.search().data);
+          xhr.send();
+        }(new XMLHttpRequest()));
+      } else if (/\.(jsonl|ndjson)$/.test($location.search().data)) {
+        // JSON Lines は受信した分から変換する
+        (function (xhr, readLines) {
+          var received = 0,
+            receive = function (isLast) {
+              var text = xhr.responseText.substring(received);
+              received = xhr.responseText.length;
+              $scope.$apply(function () {
+                readLines(text, isLast);
+                if ($scope.stages && $scope.stages.length) {
+                  $scope.isNowLoading = false;
+                }
+              });
+            };
+          xhr.onprogress = function () {
+            receive(false);
+          };
+          xhr.onload = function () {
+            receive(true);
+            finishLoading();
+          };
+          xhr.open('GET', $location.search().data);
+          xhr.send();
+        }(new XMLHttpRequest(), createLineReader()));
+      } else {
+        $.getJSON($location.search().data, function (json) {
+          $scope.$apply(function () {
+            convAll(json);
+            $scope.isNowLoading = false;
+          });
         });
+      }
+    }
+  }(function (headerJson) {
+    // 基本情報を変換
+    $scope.ninjaRadius = headerJson[0];
+    $scope.laps = headerJson[1];
+  }, function (stageJson) {
+    // ステージのJSONデータをオブジェクトに変換
+    // ターンの情報はキャラごとに並べた型付き配列に詰める
+    var turnCount = stageJson[1].length,
+      charaCount = turnCount ? stageJson[1][0][0].length : 0,
+      pos = new Float32Array(turnCount * charaCount * 2),
+      accelCounts = new Uint8Array(turnCount * charaCount),
+      lotusCounts = new Uint8Array(turnCount * charaCount);
+    _.each(stageJson[1], function (turnJson, t) {
+      _.each(turnJson[0], function (ninja, i) {
+        var index = t * charaCount + i;
+        pos[index * 2] = ninja[0];
+        pos[index * 2 + 1] = ninja[1];
+        accelCounts[index] = ninja[2];
+        lotusCounts[index] = ninja[3];
       });
+    });
+    return {
+      fieldW: stageJson[0][0],
+      fieldH: stageJson[0][1],
+      flowSpeed: stageJson[0][4],
+      lotuses: _.map(stageJson[0][2], function (lotusJson) {
+        return {
+          x: lotusJson[0],
+          y: lotusJson[1],
+          radius: lotusJson[2]
+        };
+      }),
+      rank: stageJson[0][3],
+      score: stageJson[0][5],
+      charaCount: charaCount,
+      turnCount: turnCount,
+      pos: pos,
+      accelCounts: accelCounts,
+      lotusCounts: lotusCounts
+    };
+  }, function (buffer) {
+    // バイナリを変換 (形式は RecordStage::writeBinary を参照)
+    // ターンの情報はバッファを指す型付き配列とし、ターンごとのオブジェクトは作らない
+    var view = new DataView(buffer),
+      offset = 20,
+      stageCount,
+      stages = [];
+    if (buffer.byteLength < offset || String.fromCharCode(view.getUint8(0), view.getUint8(1), view.getUint8(2), view.getUint8(3)) !== 'HPCT' || view.getUint32(4, true) !== 1) {
+      throw new Error('invalid binary');
     }
-  }(function (json) {
-    // JSONデータをオブジェクトに変換
-    $scope.ninjaRadius = json[0][0];
-    $scope.laps = json[0][1];
-    $scope.stages = _.map(json[1], function (stageJson) {
-      return {
-        fieldW: stageJson[0][0],
-        fieldH: stageJson[0][1],
-        flowSpeed: stageJson[0][4],
-        lotuses: _.map(stageJson[0][2], function (lotusJson) {
-          return {
-            x: lotusJson[0],
-            y: lotusJson[1],
-            radius: lotusJson[2]
-          };
-        }),
-        rank: stageJson[0][3],
-        score: stageJson[0][5],
-        turns: _.map(stageJson[1], function (turnJson) {
-          return {
-            ninjas: _.map(turnJson[0], function (ninja) {
-              return {
-                x: ninja[0],
-                y: ninja[1],
-                accelCount: ninja[2],
-                lotusCount: ninja[3],
-                progress: ninja[3] * 100 / (stageJson[0][2].length * $scope.laps)
-              };
-            })
-          };
-        })
-      };
+    $scope.ninjaRadius = view.getFloat32(8, true);
+    $scope.laps = view.getInt32(12, true);
+    stageCount = view.getInt32(16, true);
+    _.times(stageCount, function () {
+      var charaCount = view.getInt32(offset, true),
+        lotusCount = view.getInt32(offset + 4, true),
+        turnCount = view.getInt32(offset + 8, true),
+        stage = {
+          fieldW: view.getFloat32(offset + 16, true),
+          fieldH: view.getFloat32(offset + 20, true),
+          flowSpeed: view.getFloat32(offset + 24, true),
+          score: view.getInt32(offset + 12, true),
+          charaCount: charaCount,
+          turnCount: turnCount
+        },
+        lotuses,
+        size = turnCount * charaCount;
+      offset += 28;
+      stage.rank = Array.prototype.slice.call(new Int32Array(buffer, offset, charaCount));
+      offset += charaCount * 4;
+      lotuses = new Float32Array(buffer, offset, lotusCount * 3);
+      stage.lotuses = _.times(lotusCount, function (i) {
+        return {
+          x: lotuses[i * 3],
+          y: lotuses[i * 3 + 1],
+          radius: lotuses[i * 3 + 2]
+        };
+      });
+      offset += lotusCount * 12;
+      stage.pos = new Float32Array(buffer, offset, size * 2);
+      offset += size * 8;
+      stage.accelCounts = new Uint8Array(buffer, offset, size);
+      offset += size;
+      stage.lotusCounts = new Uint8Array(buffer, offset, size);
+      offset += size + (4 - size * 2 % 4) % 4;
+      stages.push(stage);
     });
+    $scope.stages = stages;
     $scope.currentStageNo = new Number(0);
   }));
   $scope.set = function (stageNo) {
@@ -127,17 +380,17 @@ angular.module('viewer', []).config(function ($locationProvider) {
       if (isNaN($scope.currentStageNo)) {
         $scope.currentStageNo = 0;
       }
-      $scope.currentStageNo = round($scope.currentStageNo, $scope.stages);
+      $scope.currentStageNo = round($scope.currentStageNo, $scope.stages.length);
     };
     // ターン番号を範囲内に収める
     $scope.validateTurn = function () {
       if (isNaN($scope.currentTurnNo)) {
         $scope.currentTurnNo = 0;
       }
-      $scope.currentTurnNo = round($scope.currentTurnNo, $scope.currentStage.turns);
+      $scope.currentTurnNo = round($scope.currentTurnNo, $scope.currentStage.turnCount);
     };
-  }(function (v, arr) {
-    return Math.min(Math.max(v, 0), arr.length - 1);
+  }(function (v, count) {
+    return Math.min(Math.max(v, 0), count - 1);
   }));
   // ステージ番号に変化があったら、ステージ初期化
   $scope.$watch('currentStageNo', function (currentStageNo) {
@@ -150,10 +403,20 @@ angular.module('viewer', []).config(function ($locationProvider) {
       $scope.currentStage = $scope.stages[currentStageNo];
       $slider.slider({
         min: 0,
-        max: $scope.currentStage.turns.length - 1,
+        max: $scope.currentStage.turnCount - 1,
         step: 1,
         slide: function (e, ui) {
-          $scope.$apply(function () { $scope.currentTurnNo = ui.value; });
+          $scope.$apply(function () {
+            $scope.isScrubbing = true;
+            $scope.currentTurnNo = ui.value;
+          });
+        },
+        stop: function (e, ui) {
+          // 操作が終わったら、ターンごとの描画に戻す
+          $scope.$apply(function () {
+            $scope.isScrubbing = false;
+            $scope.currentTurnNo = new Number(ui.value);
+          });
         }
       });
       width = $scope.currentStage.fieldW;
@@ -184,6 +447,15 @@ angular.module('viewer', []).config(function ($locationProvider) {
       });
       ctx.closePath();
       ctx.stroke();
+      // 忍者の全体の軌跡
+      ctx.globalAlpha = 0.5;
+      _.times($scope.currentStage.charaCount, function (i) {
+        ctx.strokeStyle = $scope.ninjaColor(i);
+        ctx.beginPath();
+        $scope.traceKeyframes(ctx, $scope.currentStage, i, 0, $scope.currentStage.turnCount - 1);
+        ctx.stroke();
+      });
+      ctx.globalAlpha = 1;
       // 蓮番号表示
       ctx.font = '12px monospace';
       ctx.textAlign = 'center';
@@ -211,39 +483,55 @@ angular.module('viewer', []).config(function ($locationProvider) {
     if (!$scope.stages) {
       return;
     }
-    $scope.currentTurn = $scope.currentStage.turns[currentTurnNo];
-    var turnsInfo = $scope.currentStage.turns,
+    var stage = $scope.currentStage,
+      charaCount = stage.charaCount,
+      pos = stage.pos,
+      base = currentTurnNo * charaCount,
       $screen = $('#ninja'),
       ctx = $screen[0].getContext('2d'),
-      width = $scope.currentStage.fieldW,
-      height = $scope.currentStage.fieldH;
+      width = stage.fieldW,
+      height = stage.fieldH;
     ctx.clearRect(0, 0, width * 10, height * 10);
-    // 忍者の残像描画
-    ctx.strokeStyle = 'rgba(255, 255, 255, 0.15)';
-    ctx.lineCap = ctx.lineJoin = 'round';
-    ctx.lineWidth = $scope.ninjaRadius * 20;
-    _.times(turnsInfo[0].ninjas.length, function (i) {
-      var start = $scope.currentTurn.ninjas[i];
-      _.times(10, function (j) {
+    if ($scope.isScrubbing) {
+      // スライダー操作中は、太い残像を重ねる代わりに直近の軌跡を間引いて細い線で描く
+      ctx.lineCap = ctx.lineJoin = 'round';
+      ctx.lineWidth = 2;
+      ctx.globalAlpha = 0.6;
+      _.times(charaCount, function (i) {
+        ctx.strokeStyle = $scope.ninjaColor(i);
         ctx.beginPath();
-        ctx.moveTo(start.x * 10, start.y * 10);
-        _.times(Math.min(j, currentTurnNo), function (k) {
-          var ninja = turnsInfo[currentTurnNo - k].ninjas[i];
-          ctx.lineTo(ninja.x * 10, ninja.y * 10);
-        });
+        $scope.traceKeyframes(ctx, stage, i, Math.max(currentTurnNo - ScrubTrailTurns, 0), +currentTurnNo);
         ctx.stroke();
       });
-    });
+      ctx.globalAlpha = 1;
+    } else {
+      // 忍者の残像描画
+      ctx.strokeStyle = 'rgba(255, 255, 255, 0.15)';
+      ctx.lineCap = ctx.lineJoin = 'round';
+      ctx.lineWidth = $scope.ninjaRadius * 20;
+      _.times(charaCount, function (i) {
+        _.times(10, function (j) {
+          ctx.beginPath();
+          ctx.moveTo(pos[(base + i) * 2] * 10, pos[(base + i) * 2 + 1] * 10);
+          _.times(Math.min(j, currentTurnNo), function (k) {
+            var index = (currentTurnNo - k) * charaCount + i;
+            ctx.lineTo(pos[index * 2] * 10, pos[index * 2 + 1] * 10);
+          });
+          ctx.stroke();
+        });
+      });
+    }
 
     // 忍者描画
     ctx.lineWidth = 1;
     ctx.strokeStyle = '#000';
-    _.each($scope.currentTurn.ninjas, function (ninja, i) {
+    _.times(charaCount, function (i) {
+      var lotusCount = stage.lotusCounts[base + i];
       ctx.beginPath();
-      $scope.progresses[i].lotusCount = ninja.lotusCount;
-      $scope.progresses[i].result = ninja.progress;
+      $scope.progresses[i].lotusCount = lotusCount;
+      $scope.progresses[i].result = lotusCount * 100 / (stage.lotuses.length * $scope.laps);
       ctx.fillStyle = $scope.ninjaColor(i);
-      ctx.arc(ninja.x * 10, ninja.y * 10, $scope.ninjaRadius * 10, 0, Math.PI * 2, false);
+      ctx.arc(pos[(base + i) * 2] * 10, pos[(base + i) * 2 + 1] * 10, $scope.ninjaRadius * 10, 0, Math.PI * 2, false);
       ctx.fill();
       ctx.stroke();
     });
@@ -254,8 +542,8 @@ angular.module('viewer', []).config(function ($locationProvider) {
     ctx.font = '12px monospace';
     ctx.textAlign = 'center';
     ctx.fillStyle = '#fff';
-    _.each($scope.currentTurn.ninjas, function (ninja) {
-      ctx.fillText(ninja.accelCount, ninja.x * 10, ninja.y * 10 + 4);
+    _.times(charaCount, function (i) {
+      ctx.fillText(stage.accelCounts[base + i], pos[(base + i) * 2] * 10, pos[(base + i) * 2 + 1] * 10 + 4);
     });
 
     // 流れ画像のオフセット設定
@@ -264,24 +552,40 @@ angular.module('viewer', []).config(function ($locationProvider) {
     $slider.slider('option', {value: currentTurnNo});
   });
   // 再生ボタンが押された場合の処理
+  // 描画は requestAnimationFrame に合わせ、経過時間が wait を超えた分だけターンを進める
   (function () {
-    var animHandle;
+    var animHandle,
+      lastTime,
+      restTime;
+    function step(time) {
+      var count;
+      if (lastTime === undefined) {
+        lastTime = time;
+      }
+      restTime += time - lastTime;
+      lastTime = time;
+      count = Math.floor(restTime / $scope.wait);
+      restTime -= count * $scope.wait;
+      if (count > 0) {
+        $scope.$apply(function () {
+          $scope.currentTurnNo = Math.min($scope.currentTurnNo + count, $scope.currentStage.turnCount - 1);
+          if ($scope.currentTurnNo >= $scope.currentStage.turnCount - 1) {
+            $scope.isPlay = false;
+          }
+        });
+      }
+      if ($scope.isPlay) {
+        animHandle = $window.requestAnimationFrame(step);
+      }
+    }
     $scope.play = function () {
       $scope.isPlay = !$scope.isPlay;
       if ($scope.isPlay) {
-        (function loop() {
-          $scope.currentTurnNo += 1;
-          if ($scope.currentTurnNo >= $scope.currentStage.turns.length - 1) {
-            $scope.isPlay = false;
-            $timeout.cancel(animHandle);
-          } else {
-            animHandle = $timeout(function () {
-              $scope.$apply(loop());
-            }, $scope.wait);
-          }
-        }());
+        lastTime = undefined;
+        restTime = $scope.wait;
+        animHandle = $window.requestAnimationFrame(step);
       } else {
-        $timeout.cancel(animHandle);
+        $window.cancelAnimationFrame(animHandle);
       }
     };
   }());